@@ -0,0 +1,121 @@
+#ifndef AUDIO_IO_H
+#define AUDIO_IO_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "audio.h"
+
+/*
+ * Extensions to the Sun audio file support of audio.h.
+ *
+ * Besides PCM16_ENCODING, the files that we read may be in one of the 8-bit
+ * ITU-T G.711 encodings below, which have one byte per sample, expanded to
+ * 16-bit linear PCM as it is read.  PCM16 is the only encoding that we write.
+ *
+ * Files that we create always have a sample rate of AUDIO_FRAME_RATE, the rate at
+ * which the DTMF filters run, and AUDIO_CHANNELS channel.  Files that we read may
+ * have any rate from AUDIO_FRAME_RATE up to AUDIO_MAX_RATE that can be decimated
+ * to AUDIO_FRAME_RATE (see dtmf_decimator.h), such as 16000 or 48000 for wideband
+ * recordings, and up to AUDIO_MAX_CHANNELS channels, such as the two legs of a
+ * recorded call, with the samples for each channel interleaved.  These are the
+ * headers accepted by audio_read_header.
+ */
+#define ULAW_ENCODING (1)
+#define ALAW_ENCODING (27)
+#define AUDIO_MAX_RATE 192000
+#define AUDIO_MAX_CHANNELS 8
+
+/*
+ * Size (in bytes) of the staging buffers used by the bulk sample I/O functions.
+ */
+#define AUDIO_IO_BUF_SIZE 8192
+
+/*
+ * Number of samples in the buffers in which audio is read and written in bulk.
+ */
+#define SAMPLE_BUF_SIZE 4096
+
+/**
+ * Read up to n two-byte audio samples from an input stream.
+ * The samples are decoded from big-endian byte order into host byte order.
+ * This is equivalent to n calls to audio_read_sample, but moves the data
+ * with a single fread, so it should be preferred whenever more than a few
+ * samples are needed.
+ *
+ *   @param in  Input stream from which samples are to be read.
+ *   @param samples  Buffer into which to store the sample values.
+ *   @param n  Maximum number of samples to read.
+ *   @return The number of samples actually read, which is less than n
+ *   only if end of input was reached or an error occurred.
+ */
+size_t audio_read_samples(FILE *in, int16_t *samples, size_t n);
+
+/**
+ * Return the number of bytes per sample in an encoding accepted by audio_read_header.
+ *
+ *   @param encoding  The encoding.  Any value other than ULAW_ENCODING or ALAW_ENCODING
+ *   is taken to be PCM16_ENCODING, here and in the functions below.
+ *   @return  1 for the G.711 encodings, otherwise AUDIO_BYTES_PER_SAMPLE.
+ */
+size_t audio_sample_size(uint32_t encoding);
+
+/**
+ * Expand n audio samples in the given encoding, as they appear in the file, to 16-bit
+ * linear samples in host byte order.  The G.711 encodings are expanded by lookup in
+ * 256-entry tables.  The data may be at the start of the samples buffer itself, so
+ * that samples can be read into a buffer and expanded in place.
+ *
+ *   @param encoding  The encoding of the data.
+ *   @param data  The n encoded samples.
+ *   @param samples  Buffer of n samples to receive the expanded values.
+ *   @param n  Number of samples.
+ */
+void audio_expand_samples(uint32_t encoding, const void *data, int16_t *samples, size_t n);
+
+/**
+ * Read up to n audio samples in the given encoding from an input stream, expanded
+ * to 16-bit linear samples in host byte order.  For PCM16_ENCODING this is the
+ * same as audio_read_samples.
+ *
+ *   @param in  Input stream from which samples are to be read.
+ *   @param encoding  The encoding of the samples, from the header of the stream.
+ *   @param samples  Buffer into which to store the sample values.
+ *   @param n  Maximum number of samples to read.
+ *   @return The number of samples actually read, which is less than n
+ *   only if end of input was reached or an error occurred.
+ */
+size_t audio_read_encoded(FILE *in, uint32_t encoding, int16_t *samples, size_t n);
+
+/**
+ * Decode n two-byte audio samples in place, from the big-endian byte order in
+ * which they were read to host byte order.  This is for use on sample data that
+ * was read by some other means than audio_read_samples, which does it already.
+ *
+ *   @param samples  Buffer of samples to be decoded.
+ *   @param n  Number of samples.
+ */
+void audio_decode_samples(int16_t *samples, size_t n);
+
+/**
+ * Encode n two-byte audio samples in place, from host byte order to big-endian
+ * byte order, for output by some other means than audio_write_samples.
+ *
+ *   @param samples  Buffer of samples to be encoded.
+ *   @param n  Number of samples.
+ */
+void audio_encode_samples(int16_t *samples, size_t n);
+
+/**
+ * Write n two-byte audio samples to an output stream, in big-endian byte order.
+ *
+ *   @param out  Output stream to which samples are to be written.
+ *   @param samples  Samples to be written.
+ *   @param n  Number of samples to write.
+ *   @return The number of samples actually written, which is less than n
+ *   only if an error occurred.
+ */
+size_t audio_write_samples(FILE *out, const int16_t *samples, size_t n);
+
+#endif
@@ -0,0 +1,147 @@
+#ifndef DTMF_ANALYSIS_H
+#define DTMF_ANALYSIS_H
+
+#include <stdint.h>
+
+#include "goertzel_plan.h"
+
+/*
+ * Factor by which the energy bound used by dtmf_block_quiet must fall short of
+ * MINUS_20DB for a block to be skipped (about 3 dB).
+ */
+#define DTMF_GATE_MARGIN 0.5
+
+/*
+ * Arithmetic used by the Goertzel filters in DTMF tone detection.
+ */
+#define GOERTZEL_ENGINE_FLOAT 0  // Double-precision filters (goertzel_bank.h).
+#define GOERTZEL_ENGINE_FIXED 1  // Integer filters (goertzel_fixed.h).
+#define GOERTZEL_ENGINE_FFT 2    // FFT of each block in place of the filters (fft_real.h).
+#define GOERTZEL_ENGINE_AUTO 3   // Float or FFT, whichever costs less (see dtmf_engine_select).
+
+/*
+ * Reentrant building blocks for DTMF tone detection.  Unlike the functions in
+ * dtmf.c, these keep no state in global variables, so they can be used by several
+ * threads at once, each analyzing its own part of the input.
+ */
+
+/*
+ * Compute the Goertzel plans for each of the DTMF frequencies at block size N.
+ *
+ *   @param plans  Array of NUM_DTMF_FREQS plans to be initialized.
+ *   @param N  The block size.
+ */
+void dtmf_plans_init(GOERTZEL_PLAN *plans, int N);
+
+/*
+ * Decide which DTMF tone, if any, is present in a block, given the strengths of
+ * each of the DTMF frequencies in that block.
+ *
+ *   @param strengths  Array of NUM_DTMF_FREQS strengths, in the order of dtmf_freqs.
+ *   @return  The DTMF symbol of the tone, or 0 if no tone is present.
+ */
+int dtmf_classify_strengths(const double *strengths);
+
+/*
+ * The constants by which dtmf_classify_strengths and the event tracker decide,
+ * as variables, for trying other values without rebuilding (see dtmf_sidecar.h).
+ * The ratios are of strengths, that is, of power.
+ */
+typedef struct dtmf_thresholds {
+    double twist;         // Largest ratio of the row and column strengths (FOUR_DB).
+    double margin;        // Smallest ratio of each to the others of its group (SIX_DB).
+    double floor;         // Smallest sum of the row and column strengths (MINUS_20DB).
+    double min_duration;  // Shortest event reported, in seconds (MIN_DTMF_DURATION).
+} DTMF_THRESHOLDS;
+
+/*
+ * The thresholds with which dtmf_classify_strengths decides.
+ */
+extern const DTMF_THRESHOLDS dtmf_default_thresholds;
+
+/*
+ * Decide as for dtmf_classify_strengths, with the specified thresholds in place
+ * of the constants.  With dtmf_default_thresholds, the decisions are the same.
+ *
+ *   @param strengths  Array of NUM_DTMF_FREQS strengths, in the order of dtmf_freqs.
+ *   @param tp  The thresholds; min_duration is not used here.
+ *   @return  The DTMF symbol of the tone, or 0 if no tone is present.
+ */
+int dtmf_classify_thresholds(const double *strengths, const DTMF_THRESHOLDS *tp);
+
+/*
+ * Energy gate: decide from the energy of a block alone, without running any
+ * filters, that the block cannot contain a DTMF tone.  Each strength is
+ * 2|X(k)|^2 / N^2, and by the Cauchy-Schwarz inequality |X(k)|^2 <= N * E for any
+ * frequency k, where E is the sum of the squares of the (normalized) samples.
+ * The two strongest components therefore sum to at most 4E/N, and a block in which
+ * that is below MINUS_20DB is rejected by dtmf_classify_strengths whatever its
+ * spectrum.  The gate applies a further margin of DTMF_GATE_MARGIN, far larger than
+ * the rounding error of either Goertzel engine, so that it never rejects a block
+ * that the filters would have accepted.
+ *
+ *   @param samples  The N samples of the block, in host byte order.
+ *   @param N  The block size.
+ *   @return  Nonzero if the block certainly contains no DTMF tone, otherwise 0.
+ */
+int dtmf_block_quiet(const int16_t *samples, int N);
+
+/*
+ * Sum of the squares of the samples of a block, on the scale of 16-bit samples.
+ * The sum is exact: N * 2^30 fits easily in 64 bits.
+ *
+ *   @param samples  The N samples of the block, in host byte order.
+ *   @param N  The block size.
+ *   @return  The energy of the block.
+ */
+int64_t dtmf_block_energy(const int16_t *samples, int N);
+
+/*
+ * The energy gate of dtmf_block_quiet, applied to an energy already computed by
+ * dtmf_block_energy, for callers that need the energy for something else as well.
+ *
+ *   @param energy  The energy of the block, as returned by dtmf_block_energy.
+ *   @param N  The block size.
+ *   @return  Nonzero if the block certainly contains no DTMF tone, otherwise 0.
+ */
+int dtmf_energy_quiet(int64_t energy, int N);
+
+/*
+ * Analyze one complete block of samples for the presence of a DTMF tone.
+ *
+ *   @param plans  The plans for the DTMF frequencies at the block size.
+ *   @param engine  GOERTZEL_ENGINE_FLOAT, GOERTZEL_ENGINE_FIXED or GOERTZEL_ENGINE_FFT.
+ *   @param samples  The plans[0].N samples of the block, in host byte order.
+ *   @param strengths  Array of NUM_DTMF_FREQS values to receive the strengths.
+ *   @return  The DTMF symbol of the tone present in the block, or 0 if none.
+ */
+int dtmf_analyze_block(const GOERTZEL_PLAN *plans, int engine, const int16_t *samples,
+                       double *strengths);
+
+/*
+ * Cost model for GOERTZEL_ENGINE_AUTO.  The float filters cost one step per sample
+ * for each frequency, bins * N in all.  The FFT engine makes FFT_TERMS transforms,
+ * each of which costs one butterfly for each pair of values in each of the
+ * log2(M/2) stages of its complex transform of size M/2, where M = fft_size(N), plus
+ * a step for each of its M inputs and for each frequency it is combined into.
+ * DTMF_FFT_COST is the cost of a butterfly relative to a filter step, as measured
+ * against the vectorized filter banks.  The transforms are shared by all of the
+ * frequencies, so the FFT pays only for banks of several hundred frequencies; for
+ * the eight-frequency banks of DTMF and the other tone families, the model chooses
+ * the filters at every block size.
+ */
+#define DTMF_FFT_COST 6.0
+
+/*
+ * Resolve GOERTZEL_ENGINE_AUTO to the engine that analyzes blocks of N samples for
+ * bins frequencies at the lower cost: GOERTZEL_ENGINE_FLOAT or GOERTZEL_ENGINE_FFT.
+ * Any other engine is returned unchanged.
+ *
+ *   @param engine  The engine requested.
+ *   @param bins  The number of frequencies to be measured.
+ *   @param N  The block size.
+ *   @return  The engine to use.
+ */
+int dtmf_engine_select(int engine, int bins, int N);
+
+#endif
@@ -0,0 +1,40 @@
+#ifndef DTMF_BATCH_H
+#define DTMF_BATCH_H
+
+#include <stdio.h>
+
+#include "dtmf_detector.h"
+
+/*
+ * Batch detection flags.
+ */
+#define DTMF_BATCH_FILES 0x1  // Input files are named on the command line.
+#define DTMF_BATCH_LIST  0x2  // Input files are named, one per line, on standard input.
+#define DTMF_BATCH_WRITE 0x4  // Write the events for each file to a file of its own.
+
+/*
+ * Detect DTMF events in each of a number of audio files, using a pool of worker
+ * threads that each take the next file not yet claimed by another.
+ *
+ * Normally the events for all the files are written to a single stream, in the
+ * order in which the files were named, with each line prefixed by the name of
+ * the file and a tab.  With DTMF_BATCH_WRITE, the events for each file are instead
+ * written to a file with the same name, but with the ".au" suffix (if any)
+ * replaced by ".txt".  The events for a file with more than one channel are also
+ * prefixed by the index of the channel and a tab (see dtmf_channels.h).  A file
+ * that cannot be read is reported on stderr, and the remaining files are processed
+ * as usual.
+ *
+ *   @param files  Names of the audio files, or NULL to read names from list_in.
+ *   @param count  Number of names in files.
+ *   @param list_in  Stream from which to read file names, one per line, if files is NULL.
+ *   @param cfg  Detector parameters, used for each file.
+ *   @param jobs  Maximum number of files to be processed at once.
+ *   @param flags  Batch detection flags.
+ *   @param events_out  Stream to which events are written, unless DTMF_BATCH_WRITE is set.
+ *   @return  0 if every file was processed successfully, otherwise EOF.
+ */
+int dtmf_detect_batch(char **files, int count, FILE *list_in, const DTMF_DETECTOR_CONFIG *cfg,
+                      int jobs, int flags, FILE *events_out);
+
+#endif
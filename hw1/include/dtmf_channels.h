@@ -0,0 +1,48 @@
+#ifndef DTMF_CHANNELS_H
+#define DTMF_CHANNELS_H
+
+#include <stdio.h>
+#include <stdint.h>
+
+#include "dtmf_detector.h"
+
+/*
+ * Type of a function to which events are reported by dtmf_detect_channels: as for
+ * DTMF_EVENT_FUNC (see dtmf_tracker.h), with the index of the channel, from 0, in
+ * which the event occurred.
+ */
+typedef void DTMF_CHANNEL_EVENT_FUNC(void *arg, int channel, int start, int end, uint8_t symbol);
+
+/*
+ * Detect DTMF events in each channel of multi-channel audio, in one pass over the
+ * audio.  There is one detector per channel, all with the same parameters.  Each
+ * buffer of interleaved frames read is separated into one run of samples per
+ * channel, and each run is fed to the detector for its channel while the buffer is
+ * still in the cache; each detector's filter bank is vectorized across the DTMF
+ * frequencies as usual.  Sample indices are frame indices, so an event at the same
+ * time in two channels has the same start and end.  Events are reported as they
+ * are completed, so the events of different channels are interleaved in order of
+ * detection.  A partial frame at the end of the input is ignored.
+ *
+ * The audio header must already have been read from audio_in.
+ *
+ *   @param audio_in  Input stream, positioned at the start of the sample data.
+ *   @param cfg  Detector parameters for each channel, including the encoding of
+ *   the input.
+ *   @param channels  Number of interleaved channels, in [1, AUDIO_MAX_CHANNELS].
+ *   @param func  Function to which events are reported.
+ *   @param arg  Argument passed to func.
+ *   @return  0 if successful, EOF if a detector could not be created.
+ */
+int dtmf_detect_channels(FILE *audio_in, const DTMF_DETECTOR_CONFIG *cfg, int channels,
+                         DTMF_CHANNEL_EVENT_FUNC *func, void *arg);
+
+/*
+ * Write an event as a line in the usual tab-separated format (see dtmf_event_print),
+ * prefixed by the index of its channel and a tab.
+ *
+ *   @param arg  The output stream, as a FILE *.
+ */
+void dtmf_channel_event_print(void *arg, int channel, int start, int end, uint8_t symbol);
+
+#endif
@@ -0,0 +1,101 @@
+#ifndef DTMF_DECIMATOR_H
+#define DTMF_DECIMATOR_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * A decimator converts audio sampled at a higher rate, such as 16000, 44100 or
+ * 48000 Hz, to AUDIO_FRAME_RATE, so that the filters for the DTMF frequencies can
+ * run at 8000 samples per second however the audio was recorded.  The input rate
+ * is reduced to a ratio up / down of AUDIO_FRAME_RATE in lowest terms, and each
+ * output sample is computed directly from the input with one phase of a polyphase
+ * low-pass filter: a windowed-sinc prototype designed at up times the input rate,
+ * with a cutoff at the Nyquist frequency of the output, split into up phases of
+ * taps coefficients each.  Only the output samples are ever computed, so the cost
+ * is taps multiplications per output sample, whatever the ratio.
+ *
+ * The filter has a Blackman window and is long enough for a transition band
+ * DECIMATOR_TRANSITION Hz wide, centered on 4000 Hz: the passband is flat to well
+ * within 0.01 dB up to the highest DTMF and MF frequencies, and anything that
+ * would alias onto them is attenuated by more than 70 dB.  The filter is centered
+ * on each output sample, so the output is not delayed: output sample i is at the
+ * time of input sample i * down / up, with the input before its start and after
+ * its end taken to be silence.
+ */
+#define DECIMATOR_TRANSITION 4000.0
+#define DECIMATOR_MAX_UP 320       // Largest up, for the ratio of 11025 Hz.
+#define DECIMATOR_CHUNK 1024       // Input samples buffered at a time.
+
+typedef struct dtmf_decimator DTMF_DECIMATOR;
+
+/*
+ * Decide whether audio at a given rate can be decimated to AUDIO_FRAME_RATE.
+ *
+ *   @param rate  The sample rate of the input, in Hz.
+ *   @return  Nonzero if the rate is from AUDIO_FRAME_RATE to AUDIO_MAX_RATE and
+ *   its ratio to AUDIO_FRAME_RATE has an up of at most DECIMATOR_MAX_UP,
+ *   otherwise 0.
+ */
+int dtmf_decimator_supported(uint32_t rate);
+
+/*
+ * Create a decimator.
+ *
+ *   @param rate  The sample rate of the input, in Hz.
+ *   @return  The new decimator, or NULL if dtmf_decimator_supported rejects the
+ *   rate or there is not enough memory.
+ */
+DTMF_DECIMATOR *dtmf_decimator_new(uint32_t rate);
+
+/*
+ * Convert input samples to output samples, as many as are available and fit.
+ * Input is consumed until it is used up or max output samples have been produced,
+ * whichever comes first; the samples that are still needed by later output
+ * samples are kept.
+ *
+ *   @param dp  The decimator.
+ *   @param in  The input samples, following those previously consumed.
+ *   @param np  The number of input samples, replaced by the number consumed.
+ *   @param out  Array to receive the output samples.
+ *   @param max  The size of out.
+ *   @return  The number of output samples produced.
+ */
+size_t dtmf_decimator_run(DTMF_DECIMATOR *dp, const int16_t *in, size_t *np, int16_t *out,
+                          size_t max);
+
+/*
+ * Signal end of input to a decimator, producing the output samples up to the time
+ * of the end of the input.  Call repeatedly, until it returns 0.
+ *
+ *   @param dp  The decimator.
+ *   @param out  Array to receive the output samples.
+ *   @param max  The size of out.
+ *   @return  The number of output samples produced.
+ */
+size_t dtmf_decimator_finish(DTMF_DECIMATOR *dp, int16_t *out, size_t max);
+
+/*
+ * Return a decimator to the start of a new input.
+ *
+ *   @param dp  The decimator.
+ */
+void dtmf_decimator_reset(DTMF_DECIMATOR *dp);
+
+/*
+ * Return the index of the input sample nearest in time to an output sample.
+ *
+ *   @param dp  The decimator.
+ *   @param index  The index of the output sample.
+ *   @return  The index of the input sample.
+ */
+int dtmf_decimator_input_index(const DTMF_DECIMATOR *dp, int index);
+
+/*
+ * Free a decimator.
+ *
+ *   @param dp  The decimator, or NULL.
+ */
+void dtmf_decimator_free(DTMF_DECIMATOR *dp);
+
+#endif
@@ -0,0 +1,97 @@
+#ifndef DTMF_DETECTOR_H
+#define DTMF_DETECTOR_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "dtmf_sidecar.h"
+#include "dtmf_tracker.h"
+#include "tone_family.h"
+
+/*
+ * A DTMF detector owns all of the state needed to turn a stream of audio samples
+ * into DTMF events: the Goertzel plans for its block size, the filter banks, any
+ * partially analyzed block, and the event tracker.  It uses no global variables,
+ * so any number of detectors can be used at once, each by one thread at a time.
+ *
+ * Samples may be pushed to a detector in pieces of any size, such as the 160-sample
+ * payloads of 20 ms RTP packets, whether or not they line up with the blocks;
+ * the filter state of a partial block is carried over to the next piece.
+ * Events are reported to a caller-supplied function (see dtmf_tracker.h):
+ * an event is opened, with an end index of -1, as soon as it has lasted
+ * MIN_DTMF_DURATION (if DTMF_TRACKER_ONSET is set in the flags), and closed,
+ * with its end index, as soon as it is over.  No memory is allocated except
+ * by dtmf_detector_new, so a detector can be used on a packet path, and reused
+ * for one call after another with dtmf_detector_reset.
+ * Given a tone family (see tone_family.h), a detector looks for the tones of that
+ * family instead of the DTMF tones, in exactly the same way.
+ * Samples at a higher rate than AUDIO_FRAME_RATE are decimated to AUDIO_FRAME_RATE
+ * as they are fed (see dtmf_decimator.h), and everything else, including the block
+ * size and the durations, is as for 8 kHz input; only the indices of the events are
+ * converted back to sample indices of the input.
+ */
+typedef struct dtmf_detector DTMF_DETECTOR;
+
+/*
+ * Parameters of a DTMF detector.
+ */
+typedef struct dtmf_detector_config {
+    int block_size;  // Number of samples in each analysis window, in [10, 1000].
+    int hop_size;    // Hop between windows, in [1, block_size], or 0 for block_size.
+    int engine;      // Goertzel engine (see const.h); must be float if hop_size < block_size.
+    int flags;       // Event tracker flags (see dtmf_tracker.h), or 0.
+    const TONE_FAMILY *family;  // Family of tones to detect, or NULL for DTMF.
+    uint32_t encoding;  // Encoding of the input (see audio.h), for the functions that read
+                        // it rather than being fed samples; 0 means PCM16_ENCODING.
+    uint32_t sample_rate;  // Sample rate of the input, in Hz; 0 means AUDIO_FRAME_RATE.
+    DTMF_SIDECAR *sidecar;  // If not NULL, the strengths of every window are written to it
+                            // (see dtmf_sidecar.h), and none is skipped by the energy gate.
+} DTMF_DETECTOR_CONFIG;
+
+/*
+ * Create a DTMF detector.
+ *
+ *   @param cfg  The parameters of the detector.
+ *   @return  The new detector, or NULL if the parameters are invalid or there is
+ *   not enough memory.
+ */
+DTMF_DETECTOR *dtmf_detector_new(const DTMF_DETECTOR_CONFIG *cfg);
+
+/*
+ * Feed samples to a DTMF detector, reporting any events that they complete.
+ *
+ *   @param dp  The detector.
+ *   @param samples  The samples, in host byte order, following those previously fed.
+ *   @param n  The number of samples.
+ *   @param func  Function to which events are reported.
+ *   @param arg  Argument passed to func.
+ */
+void dtmf_detector_feed(DTMF_DETECTOR *dp, const int16_t *samples, size_t n,
+                        DTMF_EVENT_FUNC *func, void *arg);
+
+/*
+ * Signal end of input to a DTMF detector, reporting the current event, if any.
+ * Samples of an incomplete block at the end of the input are ignored.
+ *
+ *   @param dp  The detector.
+ *   @param func  Function to which events are reported.
+ *   @param arg  Argument passed to func.
+ */
+void dtmf_detector_finish(DTMF_DETECTOR *dp, DTMF_EVENT_FUNC *func, void *arg);
+
+/*
+ * Return a DTMF detector to the start of a new input, discarding any partial block
+ * and any current event without reporting it.  The parameters are unchanged.
+ *
+ *   @param dp  The detector.
+ */
+void dtmf_detector_reset(DTMF_DETECTOR *dp);
+
+/*
+ * Free a DTMF detector.
+ *
+ *   @param dp  The detector, or NULL.
+ */
+void dtmf_detector_free(DTMF_DETECTOR *dp);
+
+#endif
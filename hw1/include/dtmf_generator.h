@@ -0,0 +1,77 @@
+#ifndef DTMF_GENERATOR_H
+#define DTMF_GENERATOR_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "dtmf_noise.h"
+
+/*
+ * A DTMF generator synthesizes the successive samples of an audio signal made up
+ * of DTMF tones and silence, optionally mixed with noise from an audio file.
+ * It owns all of its state, so any number of generators can be used at once,
+ * each by one thread at a time.  The noise may come from a noise source that
+ * is shared with other generators (see dtmf_noise.h), each of which reads the
+ * noise from the beginning.
+ */
+typedef struct dtmf_generator DTMF_GENERATOR;
+
+/*
+ * Parameters of a DTMF generator.
+ */
+typedef struct dtmf_generator_config {
+    const DTMF_NOISE *noise; // Shared noise source, or NULL to use noise_file.
+    const char *noise_file;  // Name of an audio file containing noise, or NULL if none.
+    int noise_level;         // Ratio (in dB) of noise level to DTMF tone level.
+    int noise_loop;          // Nonzero to repeat the noise, rather than stop, when it ends.
+} DTMF_GENERATOR_CONFIG;
+
+/*
+ * Create a DTMF generator, positioned at sample index 0.
+ *
+ *   @param cfg  The parameters of the generator.
+ *   @return  The new generator, or NULL if the noise file could not be opened or
+ *   does not have a valid header, or there is not enough memory.  A shared noise
+ *   source must remain open until the generator is freed.
+ */
+DTMF_GENERATOR *dtmf_generator_new(const DTMF_GENERATOR_CONFIG *cfg);
+
+/*
+ * Synthesize the next samples of the output.  The tone is computed from the
+ * absolute index of each sample, so a tone may be produced by any number of calls.
+ *
+ *   @param gp  The generator.
+ *   @param symbol  The DTMF symbol whose tone is to be produced, or 0 for silence.
+ *   @param samples  Array to receive the samples, in host byte order.
+ *   @param n  The number of samples.
+ *   @return  0 if successful, EOF if symbol is not a DTMF symbol.
+ */
+int dtmf_generator_render(DTMF_GENERATOR *gp, uint8_t symbol, int16_t *samples, size_t n);
+
+/*
+ * Check whether the silence that a generator would produce from its current
+ * position onward is all zeros; that is, whether there is no noise or the noise
+ * has been exhausted and is not looped.
+ *
+ *   @param gp  The generator.
+ *   @return  Nonzero if silence is all zeros, otherwise 0.
+ */
+int dtmf_generator_silent(const DTMF_GENERATOR *gp);
+
+/*
+ * Advance a generator over samples of silence without producing them, exactly as
+ * if they had been produced by dtmf_generator_render.
+ *
+ *   @param gp  The generator.
+ *   @param n  The number of samples.
+ */
+void dtmf_generator_skip(DTMF_GENERATOR *gp, size_t n);
+
+/*
+ * Free a DTMF generator, closing its noise source unless it is shared.
+ *
+ *   @param gp  The generator, or NULL.
+ */
+void dtmf_generator_free(DTMF_GENERATOR *gp);
+
+#endif
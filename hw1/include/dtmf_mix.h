@@ -0,0 +1,36 @@
+#ifndef DTMF_MIX_H
+#define DTMF_MIX_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Mix a block of tone with a block of noise, producing PCM16 samples:
+ *
+ *   out = (int16_t)(noise_gain * noise + tone * 0.5 * INT16_MAX * tone_gain)
+ *
+ * where each tone value is the sum of the two cosines that make up a DTMF tone,
+ * so that it lies in [-2, 2].  The expression is evaluated in exactly this order,
+ * so that the result is bit-for-bit the same as for the equivalent scalar code,
+ * and results outside the range of int16_t saturate.
+ *
+ * Since the tone values may be slightly inexact (see dtmf_generator.c), each result
+ * that lies within margin of an integer, and so might have been converted to
+ * a different integer had the tone been exact, is flagged for recomputation.
+ *
+ *   @param tone  The tone values.
+ *   @param noise  The noise samples, or NULL for no noise (in which case noise_gain
+ *   is ignored).
+ *   @param noise_gain  Gain applied to the noise.
+ *   @param tone_gain  Gain applied to the tone.
+ *   @param margin  Distance from an integer within which a result is flagged.
+ *   @param out  Array to receive the samples.
+ *   @param close  Array in which each flag is set to 1 if the result is flagged,
+ *   otherwise 0.
+ *   @param n  The number of samples.
+ *   @return  The number of results flagged.
+ */
+size_t dtmf_mix(const double *tone, const int16_t *noise, double noise_gain, double tone_gain,
+                double margin, int16_t *out, uint8_t *close, size_t n);
+
+#endif
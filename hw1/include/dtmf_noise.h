@@ -0,0 +1,57 @@
+#ifndef DTMF_NOISE_H
+#define DTMF_NOISE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * A noise source: the sample data of an audio file, held in memory so that any
+ * number of DTMF generators, in any number of threads, can read it at once, each
+ * from its own position.  Where possible the file is memory-mapped, so that the
+ * data is shared with the page cache and loaded only as it is used; otherwise it
+ * is read into memory in its entirety.  A noise source is never modified once
+ * it has been opened.
+ */
+typedef struct dtmf_noise DTMF_NOISE;
+
+/*
+ * Open a noise source.
+ *
+ *   @param path  Name of an audio file containing the noise.
+ *   @return  The noise source, or NULL if the file could not be opened, does not
+ *   have a valid header, has more than one channel or another sample rate than
+ *   AUDIO_FRAME_RATE, or could not be read, or there is not enough memory.
+ */
+DTMF_NOISE *dtmf_noise_open(const char *path);
+
+/*
+ * Get the number of samples in a noise source.
+ *
+ *   @param np  The noise source.
+ *   @return  The number of samples.
+ */
+size_t dtmf_noise_length(const DTMF_NOISE *np);
+
+/*
+ * Read samples from a noise source, converting them to host byte order.
+ *
+ *   @param np  The noise source.
+ *   @param posp  Pointer to the index of the next sample to read, which is advanced
+ *   past the samples that are read.
+ *   @param samples  Array to receive the samples.
+ *   @param n  The maximum number of samples to read.
+ *   @param loop  If nonzero, continue from the beginning of the noise when the end
+ *   is reached, rather than stopping.
+ *   @return  The number of samples read, which is less than n only if the end of
+ *   the noise was reached and loop is zero, or the noise is empty.
+ */
+size_t dtmf_noise_read(const DTMF_NOISE *np, size_t *posp, int16_t *samples, size_t n, int loop);
+
+/*
+ * Close a noise source.  It must no longer be in use by any generator.
+ *
+ *   @param np  The noise source, or NULL.
+ */
+void dtmf_noise_close(DTMF_NOISE *np);
+
+#endif
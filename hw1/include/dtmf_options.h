@@ -0,0 +1,123 @@
+#ifndef DTMF_OPTIONS_H
+#define DTMF_OPTIONS_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include "audio_io.h"
+
+/*
+ * Options of the program beyond those declared in const.h, which is provided and
+ * must not be modified.  They are set by validargs, like global_options, and their
+ * storage is in dtmf_options.c.
+ */
+
+/*
+ * Print the usage of the program, with all of its options, and exit.  This takes
+ * the place of USAGE in const.h, which lists only the options provided there.
+ */
+#define DTMF_USAGE(program_name, retcode) do { \
+fprintf(stderr, "USAGE: %s %s\n", program_name, \
+"[-h] -g|-d [-t MSEC] [-n NOISE_FILE] [-l LEVEL] [-b BLOCKSIZE] [-H HOP] [-e ENGINE] [-c COARSE] [-T TONES] [-B SIZES] [-s [-o]] [-p] [-j JOBS] [-S SIDECAR] [-r SIDECAR [-x THRESHOLDS]] [-w] [-L | FILE ...]\n" \
+"   -h       Help: displays this help menu.\n" \
+"   -g       Generate: read DTMF events from standard input, output audio data to standard output.\n" \
+"   -d       Detect: read audio data from standard input, output DTMF events to standard output.\n\n" \
+"            Optional additional parameters for -g (not permitted with -d):\n" \
+"               -t MSEC         Time duration (in milliseconds, default 1000) of the audio output.\n" \
+"               -n NOISE_FILE   specifies the name of an audio file containing \"noise\" to be combined\n" \
+"                               with the synthesized DTMF tones.\n" \
+"               -l LEVEL        specifies the loudness ratio (in dB, positive or negative) of the\n" \
+"                               noise to that of the DTMF tones.  A LEVEL of 0 (the default) means the\n" \
+"                               same level, negative values mean that the DTMF tones are louder than\n" \
+"                               the noise, positive values mean that the noise is louder than the\n" \
+"                               DTMF tones.\n" \
+"               -j JOBS         when standard output is a regular file, divide the synthesis among JOBS\n" \
+"                               threads (range [1, 256], default 1).\n\n" \
+"            Optional additional parameters for -d (not permitted with -g, except -j):\n" \
+"               -b BLOCKSIZE    specifies the number of samples (range [10, 1000], default 100)\n" \
+"                                in each block of audio to be analyzed for the presence of DTMF tones.\n" \
+"               -H HOP          analyze overlapping blocks that start every HOP samples (range\n" \
+"                               [1, BLOCKSIZE], default BLOCKSIZE), so that DTMF events are located\n" \
+"                               to within HOP samples.  Not permitted with -e fixed or -e fft, or\n" \
+"                               with -j unless with FILE ... or -L.\n" \
+"               -e ENGINE       selects the arithmetic used by the Goertzel filters: \"float\" (the\n" \
+"                               default) for double precision, or \"fixed\" for 32/64-bit integer\n" \
+"                               arithmetic directly on the 16-bit samples; or \"fft\" to measure the\n" \
+"                               tones with FFTs of each block instead, or \"auto\" to use float or\n" \
+"                               fft, whichever is estimated to be faster for the block size (for the\n" \
+"                               eight DTMF frequencies, float at every block size).\n" \
+"               -c COARSE       two-pass detection: find tones in blocks of COARSE samples (a multiple\n" \
+"                               of BLOCKSIZE, at most 1000), then locate the start and end of each\n" \
+"                               event by re-analyzing only the neighbouring audio in blocks of\n" \
+"                               BLOCKSIZE, which may then be much smaller than usual (e.g. -b 20\n" \
+"                               -c 160).  Not permitted with -H, -s, -j, FILE ... or -L.\n" \
+"               -T TONES        detect the tones of each family in the comma-separated list TONES, in\n" \
+"                               one pass: \"dtmf\", \"cpt\" (call progress: D dial, R ringback,\n" \
+"                               B busy/reorder) and \"mf\" (MF R1: the digits, K for KP, S for ST,\n" \
+"                               and P, Q, R for ST', ST'', ST''').  Each line is prefixed by\n" \
+"                               the name of the family and a tab.  BLOCKSIZE applies to dtmf only.\n" \
+"                               Not permitted with -H, -c, -s, -j, FILE ... or -L.\n" \
+"               -B SIZES        sweep: detect with each block size in the comma-separated list SIZES,\n" \
+"                               of sizes N and ranges LOW-HIGH or LOW-HIGH:STEP (e.g. 80-120:10,205),\n" \
+"                               in one pass.  Each line is prefixed by the block size and a tab, and\n" \
+"                               a summary of the events and filter time for each size is written to\n" \
+"                               stderr.  Not permitted with -b, -H, -c, -T, -s, -p, -j, -S, FILE ...\n" \
+"                               or -L.\n" \
+"               -s              Stream: process audio as soon as it arrives, write each event as soon\n" \
+"                               as it ends, and report the detection latency of each event on stderr.\n" \
+"               -o              with -s, also write a line with \"-\" in place of the end index as soon\n" \
+"                               as an event is known to have started.\n" \
+"               -p              Pipeline: read and decode the audio, filter it, and write the events\n" \
+"                               in three threads at once, for input that arrives faster than one\n" \
+"                               thread can analyze it.  Not permitted with -c, -T, -j, FILE ... or -L.\n" \
+"               -j JOBS         when standard input is a regular file, divide the analysis among JOBS\n" \
+"                               threads (range [1, 256], default 1).  Not permitted with -s, -c, -H\n" \
+"                               or -T.  With FILE ... or -L, process up to JOBS files at once instead.\n" \
+"               -S SIDECAR      also write the strengths of the DTMF frequencies in every block to the\n" \
+"                               file SIDECAR, for deciding again with -r.  Not permitted with -c, -T,\n" \
+"                               -j, FILE ... or -L.\n" \
+"               -r SIDECAR      instead of reading audio, decide each block recorded in SIDECAR again,\n" \
+"                               with the block size and hop with which it was written, and write the\n" \
+"                               events as -d would have.  Not permitted with any other option but -x.\n" \
+"               -x THRESHOLDS   with -r, decide with other thresholds: a comma-separated list of any\n" \
+"                               of twist=DB (default 4), margin=DB (default 6), floor=DB (default -20)\n" \
+"                               and duration=MSEC (default 30), e.g. -x twist=8,duration=40.\n" \
+"               FILE ...        detect DTMF events in each of the named audio files, rather than in\n" \
+"                               standard input, and write them to standard output in the order the\n" \
+"                               files are named, each line prefixed by the file name and a tab.\n" \
+"               -L              like FILE ..., but read the file names from standard input, one per line.\n" \
+"               -w              with FILE ... or -L, write the events for each file to a file of the same\n" \
+"                               name, with the suffix .au replaced by .txt, rather than to standard output.\n" \
+"            Audio with up to 8 interleaved channels may be given to -d; the events of all the channels\n" \
+"            are then detected in one pass, and each line of output is prefixed by the index of the\n" \
+"            channel (from 0) and a tab, after the file name if any.  Not permitted with -c, -T, -s, -p,\n" \
+"            -S or -B.\n" \
+"            Audio at a standard rate above 8000 Hz, up to 192000 Hz (e.g. 11025, 16000, 44100, 48000), is\n" \
+"            decimated to 8000 Hz for detection; BLOCKSIZE and HOP are still in samples at 8000 Hz, and\n" \
+"            the events are given in samples of the input.  Not permitted with -c; ignored with -j.\n" \
+); \
+exit(retcode); \
+} while(0)
+
+extern int hop_size;        // Hop between analysis windows in DTMF tone detection, or 0 if not set.
+extern int goertzel_engine; // Arithmetic used by the Goertzel filters (see dtmf_analysis.h).
+extern int coarse_size;     // Coarse block size for two-pass DTMF tone detection, or 0 if not used.
+extern int tone_families;   // Bitmap of tone families (see tone_family.h) to detect, or 0 for DTMF alone.
+extern int num_jobs;        // Number of threads used for DTMF tone detection or generation.
+extern int stream_mode;     // Streaming mode flags for DTMF tone detection (see dtmf_tracker.h), or 0.
+extern int pipeline_mode;   // Nonzero for pipelined DTMF tone detection (see dtmf_pipeline.h).
+extern int batch_mode;      // Batch detection flags (see dtmf_batch.h), or 0.
+extern char **batch_files;  // Names of input files for batch detection, if given on the command line.
+extern int batch_count;     // Number of names in batch_files.
+extern char *sidecar_file;  // Name of the strength sidecar to write (see dtmf_sidecar.h), or NULL.
+extern char *redecide_file; // Name of a strength sidecar to re-decide instead of reading audio, or NULL.
+extern char *thresholds_spec; // Decision thresholds for redecide_file, or NULL for the defaults.
+extern char *sweep_spec;    // List of block sizes to sweep in one pass (see dtmf_sweep.h), or NULL.
+
+/*
+ * Sample buffer for bulk reading and writing of audio data in dtmf.c, which may not
+ * declare arrays of its own.
+ */
+extern int16_t sample_buf[SAMPLE_BUF_SIZE];
+
+#endif
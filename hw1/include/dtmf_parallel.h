@@ -0,0 +1,67 @@
+#ifndef DTMF_PARALLEL_H
+#define DTMF_PARALLEL_H
+
+#include <stdio.h>
+
+#include "dtmf_detector.h"
+#include "dtmf_generator.h"
+#include "dtmf_script.h"
+
+/*
+ * Maximum number of worker threads for parallel detection.
+ */
+#define MAX_JOBS 256
+
+/*
+ * Check whether an input stream can be analyzed by dtmf_detect_parallel; that is,
+ * whether it refers to a regular file that can be memory-mapped.
+ *
+ *   @param audio_in  The input stream.
+ *   @return  Nonzero if the stream refers to a regular file, otherwise 0.
+ */
+int dtmf_parallel_ok(FILE *audio_in);
+
+/*
+ * Chunk-parallel block-by-block DTMF detection over a memory-mapped audio file.
+ * The audio header must already have been read from audio_in, so that its file
+ * position is at the start of the sample data.  The sample data is divided into
+ * contiguous chunks of whole blocks, one per worker thread, and each worker
+ * reduces its chunk to one DTMF decision per block.  The decisions are then
+ * presented to an event tracker in order, which stitches together any events that
+ * span chunk boundaries.  Since each block is analyzed independently of all the
+ * others, the result is exactly the same as for sequential detection.
+ *
+ *   @param audio_in  Input stream, positioned at the start of the sample data.
+ *   @param cfg  Detector parameters, which must specify block-by-block detection
+ *   (hop_size 0 or block_size), no streaming mode flags, and input at
+ *   AUDIO_FRAME_RATE.
+ *   @param jobs  Number of worker threads to use.
+ *   @param func  Function to which events are reported.
+ *   @param arg  Argument passed to func.
+ *   @return  0 if successful, EOF if the file could not be mapped, a thread could
+ *   not be created, or the input is at another rate.
+ */
+int dtmf_detect_parallel(FILE *audio_in, const DTMF_DETECTOR_CONFIG *cfg, int jobs,
+                         DTMF_EVENT_FUNC *func, void *arg);
+
+/*
+ * Time-parallel DTMF generation into a regular file.  Each sample depends only on
+ * its index and on the event (if any) in which it lies, so the output is divided
+ * into contiguous segments, one per worker thread, and each worker synthesizes its
+ * segment with a generator of its own, advanced to the start of the segment, and
+ * writes it with pwrite at the corresponding offset in the file.  The result is
+ * exactly the same as for sequential generation.  Runs of zeros that lie beyond
+ * the original end of the file are not written, but left as holes.
+ *
+ *   @param audio_out  Output stream, which must refer to a regular file not opened
+ *   for appending, positioned where the first sample is to be written.  On return
+ *   it is positioned after the last sample.
+ *   @param sp  The script of events to be synthesized.
+ *   @param cfg  Generator parameters, used for each worker.
+ *   @param jobs  Number of worker threads to use.
+ *   @return  0 if successful, EOF if an error occurred.
+ */
+int dtmf_generate_parallel(FILE *audio_out, const DTMF_SCRIPT *sp, const DTMF_GENERATOR_CONFIG *cfg,
+                           int jobs);
+
+#endif
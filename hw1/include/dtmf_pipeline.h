@@ -0,0 +1,51 @@
+#ifndef DTMF_PIPELINE_H
+#define DTMF_PIPELINE_H
+
+#include <stdio.h>
+#include <stdint.h>
+
+#include "dtmf_detector.h"
+
+/*
+ * Number of samples in each slot of the ring between the reader and the filters,
+ * and number of slots in each of the rings.
+ */
+#define PIPELINE_SLOT_SAMPLES 4096
+#define PIPELINE_SAMPLE_SLOTS 16
+#define PIPELINE_EVENT_SLOTS 256
+
+/*
+ * Pipelined DTMF detection, for a stream that must be analyzed in order but at a
+ * rate that one thread cannot sustain while also doing the I/O.  The work is
+ * divided among three stages, each in a thread of its own:
+ *
+ *   - the reader reads whatever sample data is available from the input, decodes
+ *     it to 16-bit samples in host byte order, and passes it on in slots of up to
+ *     PIPELINE_SLOT_SAMPLES samples;
+ *   - the filter stage feeds the samples to the detector, which runs the filters,
+ *     decides each block and tracks the events, and passes each event on as it is
+ *     reported;
+ *   - the writer, which is the calling thread, reports each event to func.
+ *
+ * Consecutive stages are connected by single-producer, single-consumer ring
+ * buffers, in which the producer and the consumer each advance an index of their
+ * own with C11 atomic operations, so that neither ever takes a lock.  A stage that
+ * finds its input ring empty or its output ring full spins briefly, then yields,
+ * then sleeps for short intervals until it can continue.  The events, and the
+ * order in which they are reported, are exactly those of feeding the whole input
+ * to the detector in one thread.
+ *
+ *   @param audio_in  Input stream, positioned at the start of the sample data, from
+ *   which the data is read with read(2); none of it may be held in a stdio buffer.
+ *   @param encoding  The encoding of the sample data (see audio.h).
+ *   @param dp  The detector, newly created or reset.  It is finished at the end of
+ *   the input, unless an error occurs.
+ *   @param func  Function to which events are reported, from the calling thread.
+ *   @param arg  Argument passed to func.
+ *   @return  0 if successful, EOF if a read error occurred or a thread could not be
+ *   created.
+ */
+int dtmf_detect_pipeline(FILE *audio_in, uint32_t encoding, DTMF_DETECTOR *dp,
+                         DTMF_EVENT_FUNC *func, void *arg);
+
+#endif
@@ -0,0 +1,53 @@
+#ifndef DTMF_REFINE_H
+#define DTMF_REFINE_H
+
+#include <stdio.h>
+
+#include "dtmf_detector.h"
+
+/*
+ * Share of the power of a fine block that the row and column frequencies of a
+ * candidate tone must carry for the tone to be confirmed there.  For a noiseless
+ * dual tone, the two strengths together come to half of the power of the block on
+ * the same scale (2E/N), so this asks for half of what such a tone would give.
+ */
+#define DTMF_REFINE_SHARE 0.25
+
+/*
+ * Coarse-to-fine two-pass DTMF detection.  The first pass analyzes the whole
+ * input in coarse blocks of COARSE samples, as block-by-block detection would.
+ * The second pass locates the boundaries of the events to within a fine block of
+ * cfg -> block_size samples, by re-analyzing only the neighbourhoods of the
+ * transitions: each coarse block whose decision differs from that of either of its
+ * neighbours.  Inside a run of three or more coarse blocks with the same decision,
+ * every fine block is given that decision without being analyzed.  The fine
+ * decisions are then presented to an event tracker as for block-by-block detection
+ * at cfg -> block_size, so the output has the same form.
+ *
+ * A fine block near a transition is not classified from scratch, which would need
+ * a block long enough to resolve the DTMF frequencies, but is only tested for the
+ * presence of the tones decided for the coarse block in which it lies and for its
+ * neighbours.  Fine blocks much shorter than the usual block size can therefore be
+ * used, and the total cost is little more than that of the coarse pass.
+ *
+ * An event shorter than about two coarse blocks may fail to cover any coarse block
+ * completely, and so go unnoticed in the first pass; COARSE should therefore be no
+ * more than half the length of the shortest event of interest.
+ *
+ * The audio header must already have been read from audio_in.  A regular file is
+ * memory-mapped; any other input is read into memory in full.
+ *
+ *   @param audio_in  Input stream, positioned at the start of the sample data.
+ *   @param cfg  Detector parameters, which must specify block-by-block detection
+ *   (hop_size 0 or block_size), no streaming mode flags, and input at
+ *   AUDIO_FRAME_RATE.
+ *   @param coarse  The coarse block size, a multiple of cfg -> block_size.
+ *   @param func  Function to which events are reported.
+ *   @param arg  Argument passed to func.
+ *   @return  0 if successful, EOF if the input could not be read, is at another
+ *   rate, or there was not enough memory.
+ */
+int dtmf_detect_refine(FILE *audio_in, const DTMF_DETECTOR_CONFIG *cfg, int coarse,
+                       DTMF_EVENT_FUNC *func, void *arg);
+
+#endif
@@ -0,0 +1,107 @@
+#ifndef DTMF_SCRIPT_H
+#define DTMF_SCRIPT_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+/*
+ * One DTMF event: the tone for symbol, in the samples with indices in [start, end).
+ */
+typedef struct dtmf_event {
+    uint32_t start;
+    uint32_t end;
+    uint8_t symbol;
+} DTMF_EVENT;
+
+/*
+ * A script for DTMF generation: the events to be synthesized, in increasing order
+ * of start index and non-overlapping, and the number of samples to be written.
+ * The samples outside of any event are silent.
+ */
+typedef struct dtmf_script {
+    DTMF_EVENT *events;
+    size_t count;    // Number of events.
+    size_t cap;      // Number of events for which space is allocated.
+    uint32_t length; // Number of samples to be written.
+} DTMF_SCRIPT;
+
+/*
+ * Initialize an empty script.
+ *
+ *   @param sp  The script.
+ */
+void dtmf_script_init(DTMF_SCRIPT *sp);
+
+/*
+ * Append an event to a script.  The event must start no earlier than the end of
+ * the last event.
+ *
+ *   @param sp  The script.
+ *   @return  0 if successful, EOF if there was not enough memory.
+ */
+int dtmf_script_add(DTMF_SCRIPT *sp, uint32_t start, uint32_t end, uint8_t symbol);
+
+/*
+ * Read a script for output of a given length from DTMF events in textual form:
+ * one event per line, with the start index, end index and symbol separated by
+ * tabs.  The input is read in large blocks and tokenized in place, so that scripts
+ * with millions of events can be read in about the time it takes to copy them.
+ *
+ * Events that start at or after the end of the output, and any that follow them,
+ * are ignored, and an event that extends beyond the end is cut short.  If a line
+ * is malformed, or its event overlaps the previous one or has an invalid symbol,
+ * then a message identifying the line is printed on stderr and reading stops
+ * there.  The script is then cut short at the point where the output would have
+ * stopped had it been written as the events were read: at the end of the previous
+ * event, or at the start of an event with an invalid symbol.
+ *
+ *   @param sp  An empty script, which is filled in.
+ *   @param in  Stream from which to read the events.
+ *   @param length  Number of samples to be written.
+ *   @return  0 if successful, EOF if there was an invalid line, a read error, or
+ *   not enough memory.
+ */
+int dtmf_script_read(DTMF_SCRIPT *sp, FILE *in, uint32_t length);
+
+/*
+ * Function to which the events of a script are passed as they are read.  The
+ * events in sp -> events are those read since the last call, and sp -> length is
+ * final only after the last call, when dtmf_script_stream returns.
+ */
+typedef void DTMF_SCRIPT_FUNC(void *arg, const DTMF_SCRIPT *sp);
+
+/*
+ * Read a script as for dtmf_script_read, but pass the events to func after each
+ * block of input is parsed, and then remove them from the script, so that output
+ * can be written while the rest of the input is still being read, and the script
+ * never holds more than one block's worth of events.
+ *
+ *   @param sp  An empty script, which holds the events of each block in turn, and is
+ *   left empty, with its final length.
+ *   @param in  Stream from which to read the events.
+ *   @param length  Number of samples to be written.
+ *   @param func  Function to which to pass the events.
+ *   @param arg  Argument passed to func.
+ *   @return  As for dtmf_script_read.
+ */
+int dtmf_script_stream(DTMF_SCRIPT *sp, FILE *in, uint32_t length, DTMF_SCRIPT_FUNC *func,
+                       void *arg);
+
+/*
+ * Find the first event of a script that ends after a given sample index.
+ *
+ *   @param sp  The script.
+ *   @param index  The sample index.
+ *   @return  The position of the event in sp -> events, or sp -> count if none.
+ */
+size_t dtmf_script_find(const DTMF_SCRIPT *sp, uint32_t index);
+
+/*
+ * Free the storage of a script, leaving it empty.
+ *
+ *   @param sp  The script.
+ */
+void dtmf_script_free(DTMF_SCRIPT *sp);
+
+#endif
@@ -0,0 +1,95 @@
+#ifndef DTMF_SIDECAR_H
+#define DTMF_SIDECAR_H
+
+#include <stdint.h>
+
+#include "dtmf_analysis.h"
+#include "dtmf_tracker.h"
+
+/*
+ * A strength sidecar records the strengths of the DTMF frequencies in every window
+ * analyzed by a detector, so that the decisions can be made again later, with
+ * other thresholds, without reading the audio or running any filters.  When tuning
+ * the decision constants over a large archive, each audio file is then analyzed
+ * once, and each further setting of the thresholds costs only a pass over the
+ * sidecars, which are a small fraction of the size of the audio.
+ *
+ * A sidecar is a header of SIDECAR_HEADER_SIZE bytes, followed by one record of
+ * NUM_DTMF_FREQS single-precision strengths per window, in the order of dtmf_freqs.
+ * Everything is in host byte order; a sidecar written on a machine of the other
+ * byte order is rejected by its magic number.  The header holds, as 32-bit values:
+ *
+ *   - SIDECAR_MAGIC;
+ *   - the number of strengths in each record, NUM_DTMF_FREQS;
+ *   - the window (block) size, in samples at AUDIO_FRAME_RATE;
+ *   - the hop between windows, equal to the window size for block-by-block detection;
+ *   - the sample rate of the input, from which the indices of the events are
+ *     computed as by a detector decimating from that rate (see dtmf_decimator.h);
+ *   - 0, reserved.
+ *
+ * Window i starts at sample i times the hop, and the number of windows is given by
+ * the size of the file.  Single precision is ample for the decisions: the
+ * strengths of a window decided differently from its double-precision strengths
+ * would have to be within a few parts in 10^7 of a threshold.
+ */
+#define SIDECAR_MAGIC 0x44545331  // "DTS1"
+#define SIDECAR_HEADER_SIZE 24
+
+typedef struct dtmf_sidecar DTMF_SIDECAR;
+
+/*
+ * Create a sidecar and write its header.
+ *
+ *   @param path  Name of the file, which is created or truncated.
+ *   @param block_size  The window size of the detector.
+ *   @param hop_size  The hop between windows, or 0 for block_size.
+ *   @param sample_rate  The sample rate of the input, or 0 for AUDIO_FRAME_RATE.
+ *   @return  The sidecar, or NULL if the file could not be created.
+ */
+DTMF_SIDECAR *dtmf_sidecar_create(const char *path, int block_size, int hop_size,
+                                  uint32_t sample_rate);
+
+/*
+ * Append the strengths of the next window to a sidecar.  The record is buffered,
+ * and any error is reported by dtmf_sidecar_close.
+ *
+ *   @param sp  The sidecar.
+ *   @param strengths  Array of NUM_DTMF_FREQS strengths.
+ */
+void dtmf_sidecar_write(DTMF_SIDECAR *sp, const double *strengths);
+
+/*
+ * Close a sidecar.
+ *
+ *   @param sp  The sidecar, or NULL.
+ *   @return  0 if every record was written successfully, otherwise EOF.
+ */
+int dtmf_sidecar_close(DTMF_SIDECAR *sp);
+
+/*
+ * Re-decide the windows recorded in a sidecar with the specified thresholds, and
+ * report the events as a detector with those thresholds would have.  With
+ * dtmf_default_thresholds, the events are those reported by the detector that
+ * wrote the sidecar.  The sidecar is memory-mapped, so it must be a regular file.
+ *
+ *   @param path  Name of the sidecar.
+ *   @param tp  The thresholds.
+ *   @param func  Function to which events are reported.
+ *   @param arg  Argument passed to func.
+ *   @return  0 if successful, EOF if the sidecar could not be mapped or is not valid.
+ */
+int dtmf_redecide(const char *path, const DTMF_THRESHOLDS *tp, DTMF_EVENT_FUNC *func, void *arg);
+
+/*
+ * Parse thresholds from a comma-separated list of settings NAME=VALUE, where NAME
+ * is "twist", "margin" or "floor", with a VALUE in dB, or "duration", with a VALUE
+ * in milliseconds.  Each setting may appear at most once, and the thresholds not
+ * set keep their default values, as in dtmf_default_thresholds.
+ *
+ *   @param spec  The list of settings.
+ *   @param tp  The thresholds to be set.
+ *   @return  0 if successful, -1 if the list is not valid.
+ */
+int dtmf_thresholds_parse(const char *spec, DTMF_THRESHOLDS *tp);
+
+#endif
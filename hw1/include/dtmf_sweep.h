@@ -0,0 +1,61 @@
+#ifndef DTMF_SWEEP_H
+#define DTMF_SWEEP_H
+
+#include <stdio.h>
+
+#include "dtmf_detector.h"
+
+/*
+ * Largest number of block sizes in a sweep: enough for every valid block size.
+ */
+#define SWEEP_MAX_SIZES 1000
+
+/*
+ * Detect DTMF events with each of a number of block sizes, in one pass over the
+ * audio, for choosing the block size that suits a source.  There is one detector
+ * per block size, and every buffer of samples is read and decoded once and then
+ * fed to each of them in turn while it is still in the cache, so the cost of the
+ * I/O and decoding does not grow with the number of block sizes.  Each event is
+ * written as a line in the usual tab-separated format, prefixed by its block size
+ * and a tab; events are written as they are completed, so the lines for different
+ * block sizes are interleaved in order of detection.
+ *
+ * At the end of the input, a summary is written to stats_out: a header line, then
+ * one line per block size, in the order listed, with tab-separated fields
+ *
+ *   size  events  tone_ms  shortest_ms  filter_ms
+ *
+ * giving the number of events, their total and shortest duration, and the time
+ * spent in the detector for that size (filtering, deciding and tracking), not
+ * counting the time taken to write its events.
+ *
+ * The audio header must already have been read from audio_in.
+ *
+ *   @param audio_in  Input stream, positioned at the start of the sample data.
+ *   @param cfg  Detector parameters for each size, including the encoding and sample
+ *   rate of the input; block_size is ignored, and hop_size must be 0.
+ *   @param spec  The list of block sizes, as for dtmf_sweep_parse.
+ *   @param events_out  Stream to which to write the events.
+ *   @param stats_out  Stream to which to write the summary.
+ *   @return  0 if successful, EOF if the list is not valid or a detector could not
+ *   be created.
+ */
+int dtmf_detect_sweep(FILE *audio_in, const DTMF_DETECTOR_CONFIG *cfg, const char *spec,
+                      FILE *events_out, FILE *stats_out);
+
+/*
+ * Parse a comma-separated list of block sizes, each either a single size N or a
+ * range LOW-HIGH or LOW-HIGH:STEP, meaning every STEP-th size (default 1) from LOW
+ * to at most HIGH.  Every size must be in [10, 1000], and no size may appear more
+ * than once.
+ *
+ *   @param spec  The list.
+ *   @param sizes  Array of max values to receive the sizes, in order, or NULL if the
+ *   list is only to be checked.
+ *   @param max  The size of sizes.
+ *   @return  The number of sizes, or -1 if the list is not valid or has more than
+ *   max sizes.
+ */
+int dtmf_sweep_parse(const char *spec, int *sizes, int max);
+
+#endif
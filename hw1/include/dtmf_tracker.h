@@ -0,0 +1,135 @@
+#ifndef DTMF_TRACKER_H
+#define DTMF_TRACKER_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <time.h>
+
+/*
+ * State of the logic that turns a sequence of per-window DTMF decisions into
+ * DTMF events.  Each analysis window is WINDOW samples long, and is identified
+ * by the index of its first sample.  Windows are presented in increasing order
+ * of index; for block-by-block detection they are adjacent, for sliding detection
+ * they overlap.
+ *
+ * An event begins at the first window in which its tone is present, and ends at
+ * the end of the last window in which it is present, unless a window with a
+ * different tone comes first, in which case the event ends where that window
+ * begins.  For adjacent windows these are the same thing, so the events are
+ * exactly the ones described in the specification of dtmf_detect.
+ * An event never begins before the end of the previously emitted one.
+ *
+ * Overlapping windows are presented with dtmf_tracker_slide instead, along with the
+ * power of the tone in each window.  A tone is detected in windows that it fills
+ * only partly, so the first and last windows in which it is present would place the
+ * boundaries of the event up to most of a window too early and too late.  But the
+ * amplitude of the tone in a window is proportional to the part of the window that
+ * it fills, so the square root of the ratio of the power in the first window to the
+ * greatest power in any window tells how much of the first window the tone fills,
+ * and where in it the tone therefore begins; likewise for the last window and the
+ * end.  These boundaries are rounded to the nearest multiple of the hop.
+ *
+ * Events are reported to a caller-supplied function as they are completed.
+ * In streaming mode (see dtmf_tracker_stream), the onset of each event can
+ * optionally be announced as soon as it is known that the event will be
+ * reported, with an end index of -1.
+ */
+typedef struct dtmf_tracker {
+    int window;      // Length of each analysis window.
+    int start;       // Start index of the current event, or -1 if none.
+    int last;        // Index of the last window in which the current tone was present.
+    int hop;         // Hop between overlapping windows (see dtmf_tracker_slide).
+    double first_power;  // For overlapping windows, the power of the current tone in
+    double last_power;   // its first and last windows, and the greatest power in any.
+    double peak;
+    int floor;       // End index of the last event emitted.
+    uint8_t tone;    // DTMF symbol of the current event, or 0 if none.
+    int flags;       // Streaming mode flags (see below).
+    int announced;   // Nonzero if the onset of the current event has been announced.
+    struct timespec t0;  // Time at which streaming began.
+    double min_duration;  // Shortest event reported, in seconds; MIN_DTMF_DURATION by default.
+    uint32_t rate;   // Sample rate of the input, for the indices in latency reports, if
+                     // the windows are of input decimated to AUDIO_FRAME_RATE.
+} DTMF_TRACKER;
+
+/*
+ * Type of a function to which a tracker reports events.  It is called with the
+ * caller-supplied argument, the start and end indices of the event, and its
+ * DTMF symbol.  An end index of -1 announces the onset of an event whose end
+ * is not yet known.
+ */
+typedef void DTMF_EVENT_FUNC(void *arg, int start, int end, uint8_t symbol);
+
+/*
+ * Streaming mode flags.
+ */
+#define DTMF_TRACKER_STREAM 0x1  // Flush each line, and report latency on stderr.
+#define DTMF_TRACKER_ONSET  0x2  // Announce the onset of each event.
+
+/*
+ * Initialize an event tracker.  The hop is set to the window, for adjacent windows.
+ *
+ *   @param tp  Pointer to the tracker.
+ *   @param window  Length of each analysis window.
+ */
+void dtmf_tracker_init(DTMF_TRACKER *tp, int window);
+
+/*
+ * Put an event tracker into streaming mode.  Latency is measured from the
+ * time of this call, which should be when the first sample is about to arrive.
+ * For each event reported, the sample index at which it could first have been
+ * reported is compared with the elapsed wall-clock time, and the difference
+ * is reported on stderr.
+ *
+ *   @param tp  Pointer to the tracker.
+ *   @param flags  Bitwise OR of DTMF_TRACKER_STREAM and, optionally, DTMF_TRACKER_ONSET.
+ */
+void dtmf_tracker_stream(DTMF_TRACKER *tp, int flags);
+
+/*
+ * Present the decision for one analysis window to an event tracker.
+ * If this completes an event of at least MIN_DTMF_DURATION, the event is reported.
+ *
+ *   @param tp  Pointer to the tracker.
+ *   @param index  Index of the first sample of the window.
+ *   @param symbol  The DTMF symbol present in the window, or 0 if none.
+ *   @param func  Function to which events are reported.
+ *   @param arg  Argument passed to func.
+ */
+void dtmf_tracker_window(DTMF_TRACKER *tp, int index, uint8_t symbol, DTMF_EVENT_FUNC *func, void *arg);
+
+/*
+ * Present the decision for one of a sequence of overlapping analysis windows, which
+ * start every tp -> hop samples, to an event tracker, as for dtmf_tracker_window.
+ * All the windows of an input must be presented in the same way.
+ *
+ *   @param tp  Pointer to the tracker.
+ *   @param index  Index of the first sample of the window.
+ *   @param symbol  The DTMF symbol present in the window, or 0 if none.
+ *   @param power  The power of that tone in the window, the sum of the strengths of
+ *   its frequencies, or 0 if none.
+ *   @param func  Function to which events are reported.
+ *   @param arg  Argument passed to func.
+ */
+void dtmf_tracker_slide(DTMF_TRACKER *tp, int index, uint8_t symbol, double power,
+                        DTMF_EVENT_FUNC *func, void *arg);
+
+/*
+ * Signal end of input to an event tracker, reporting the current event, if any,
+ * as for dtmf_tracker_window.
+ *
+ *   @param tp  Pointer to the tracker.
+ *   @param func  Function to which events are reported.
+ *   @param arg  Argument passed to func.
+ */
+void dtmf_tracker_finish(DTMF_TRACKER *tp, DTMF_EVENT_FUNC *func, void *arg);
+
+/*
+ * Event reporting function that writes each event to a stream as a line of text
+ * in tab-separated format, with "-" in place of the end index of an onset.
+ *
+ *   @param arg  The FILE * to which to write.
+ */
+void dtmf_event_print(void *arg, int start, int end, uint8_t symbol);
+
+#endif
@@ -0,0 +1,54 @@
+#ifndef FFT_REAL_H
+#define FFT_REAL_H
+
+#include <stdint.h>
+
+#include "goertzel_plan.h"
+
+/*
+ * An alternative to the Goertzel filters for measuring the strengths of a bank of
+ * frequency components in a block of samples: radix-2 FFTs of the block, from which
+ * the strength of each component is computed at its own frequency.  The block is
+ * real, so its N samples, zero-padded to M = fft_size(N), are packed into M/2
+ * complex values and transformed with a complex FFT of size M/2, and only the bins
+ * that are wanted are unpacked from that.  The twiddle factors for every size up to
+ * FFT_MAX_SIZE are taken from a single table, which is computed at startup.
+ *
+ * The frequency indices k of the DTMF frequencies are not integers, so the bins
+ * of an FFT do not fall on them, and reading the nearest bin would classify some
+ * blocks differently from the filters.  Instead, the difference between each
+ * frequency and its nearest bin is corrected for with a Taylor series: the
+ * transforms of the block weighted by successive powers of the distance of each
+ * sample from the middle of the block, combined at that bin, give the transform at
+ * the frequency itself.  Padding the block to at least FFT_PADDING times its length
+ * puts a bin within N / (2 M) <= 1/4 of a frequency index of each frequency, where
+ * FFT_TERMS terms leave a remainder below (pi / 4)^17 / 17! < 1e-16 of the sum of the
+ * samples, under the rounding error of the filters themselves.
+ */
+#define FFT_PADDING 2
+#define FFT_TERMS 17
+#define FFT_MAX_SIZE 2048  // FFT_PADDING times the largest block, rounded up.
+
+/*
+ * Return the size of the transform used for blocks of N samples.
+ *
+ *   @param N  The block size, at most FFT_MAX_SIZE / FFT_PADDING.
+ *   @return  The smallest power of two that is at least FFT_PADDING * N.
+ */
+int fft_size(int N);
+
+/*
+ * Compute the strengths of a bank of frequency components in a block of samples
+ * with FFTs, in place of running a Goertzel filter for each of them.
+ *
+ *   @param plans  Array of count plans, all for the same block size N, giving the
+ *   frequency index k of each component.
+ *   @param count  The number of components.
+ *   @param samples  The N samples of the block, in host byte order.
+ *   @param strengths  Array of count values to receive the strengths, on the same
+ *   scale as goertzel_plan_strength.
+ */
+void fft_strengths(const GOERTZEL_PLAN *plans, int count, const int16_t *samples,
+                   double *strengths);
+
+#endif
@@ -0,0 +1,75 @@
+#ifndef GOERTZEL_BANK_H
+#define GOERTZEL_BANK_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "goertzel.h"
+
+/*
+ * Number of filters in a bank: one for each DTMF frequency.
+ * This must be a multiple of four, so that the bank divides evenly into
+ * 256-bit (AVX) or 128-bit (SSE2) vectors of doubles.
+ */
+#define GOERTZEL_BANK_SIZE 8
+
+/*
+ * A bank of Goertzel filters that all analyze the same signal, with the state
+ * of the individual filters stored as a structure of arrays rather than as an
+ * array of GOERTZEL_STATE structures.  This allows all the filters in the bank
+ * to be advanced by a single vector step for each sample, with the filter state
+ * held in registers for the whole block.  The fields have the same meaning as
+ * in GOERTZEL_STATE; s0 is not stored, because it never outlives a step.
+ */
+typedef struct goertzel_bank {
+    uint32_t N;                                      // Number of samples in the signal.
+    double k[GOERTZEL_BANK_SIZE];                    // Frequency "index" of each filter.
+    double A[GOERTZEL_BANK_SIZE];                    // 2 * pi * k / N for each filter.
+    double B[GOERTZEL_BANK_SIZE] __attribute__((aligned(32)));   // 2 * cos(A).
+    double s1[GOERTZEL_BANK_SIZE] __attribute__((aligned(32)));  // Filter state variables.
+    double s2[GOERTZEL_BANK_SIZE] __attribute__((aligned(32)));
+} GOERTZEL_BANK;
+
+/*
+ * Load a bank of Goertzel filters from the state of individual filter instances,
+ * which would normally just have been initialized by goertzel_init.
+ * All the instances must have been initialized with the same N.
+ *
+ *   @param bp  Pointer to the bank to be loaded.
+ *   @param states  Array of GOERTZEL_BANK_SIZE filter states, one per filter.
+ */
+void goertzel_bank_load(GOERTZEL_BANK *bp, const GOERTZEL_STATE *states);
+
+/*
+ * Perform one iteration of the main loop of the Goertzel algorithm on every
+ * filter in the bank.
+ *
+ *   @param bp  Pointer to the bank.
+ *   @param x  The sample of the signal at the current iteration.
+ */
+void goertzel_bank_step(GOERTZEL_BANK *bp, double x);
+
+/*
+ * Perform n iterations of the main loop of the Goertzel algorithm on every filter
+ * in the bank, taking the input from a buffer of PCM16 samples.  Each sample is
+ * scaled to the range [-1, 1] by dividing by INT16_MAX before it is filtered.
+ * On CPUs that support them, AVX or SSE2 instructions are used to advance all
+ * the filters at once; otherwise each filter is stepped in turn.  The results
+ * are identical either way.
+ *
+ *   @param bp  Pointer to the bank.
+ *   @param samples  The samples to be filtered.
+ *   @param n  The number of samples.
+ */
+void goertzel_bank_run(GOERTZEL_BANK *bp, const int16_t *samples, size_t n);
+
+/*
+ * Copy the state of each filter in the bank back into an array of GOERTZEL_STATE
+ * structures, so that the final iteration can be carried out by goertzel_strength.
+ *
+ *   @param bp  Pointer to the bank.
+ *   @param states  Array of GOERTZEL_BANK_SIZE structures to receive the state.
+ */
+void goertzel_bank_store(GOERTZEL_BANK *bp, GOERTZEL_STATE *states);
+
+#endif
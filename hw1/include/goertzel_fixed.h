@@ -0,0 +1,67 @@
+#ifndef GOERTZEL_FIXED_H
+#define GOERTZEL_FIXED_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "goertzel.h"
+#include "goertzel_bank.h"
+
+/*
+ * Number of fraction bits in the fixed-point filter coefficients.
+ * Since |B| = |2 cos(A)| <= 2, a Q29 coefficient always fits in 32 bits.
+ */
+#define GOERTZEL_Q_SHIFT 29
+
+/*
+ * A bank of Goertzel filters that runs the recursion in integer arithmetic,
+ * directly on PCM16 samples instead of on samples converted to double.
+ *
+ * The state variables are kept in the same units as the samples themselves;
+ * that is, s = INT16_MAX * (the state of the floating-point filter).
+ * Each step computes s0 = x + round(B * s1) - s2, with B in Q29 and the product
+ * formed in 64 bits.  The state always fits in 32 bits: the impulse response of
+ * the filter is bounded by 1/sin(A), so after N steps |s| <= N * 32768 / sin(A),
+ * which for N <= 1000 and the DTMF frequencies is less than 2^27.
+ * The state and coefficients are stored in 64-bit lanes, so that the vector
+ * version can use the signed 32x32->64-bit multiply instructions directly.
+ */
+typedef struct goertzel_qbank {
+    uint32_t N;                                       // Number of samples in the signal.
+    int64_t B[GOERTZEL_BANK_SIZE] __attribute__((aligned(32)));   // Q29 2*cos(A).
+    int64_t s1[GOERTZEL_BANK_SIZE] __attribute__((aligned(32)));  // Filter state variables.
+    int64_t s2[GOERTZEL_BANK_SIZE] __attribute__((aligned(32)));
+} GOERTZEL_QBANK;
+
+/*
+ * Load a fixed-point bank from the state of individual filter instances,
+ * converting the coefficients to Q29 and the state variables to sample units.
+ *
+ *   @param qp  Pointer to the bank to be loaded.
+ *   @param states  Array of GOERTZEL_BANK_SIZE filter states, one per filter.
+ */
+void goertzel_qbank_load(GOERTZEL_QBANK *qp, const GOERTZEL_STATE *states);
+
+/*
+ * Perform n iterations of the main loop of the Goertzel algorithm on every
+ * filter in the bank, in integer arithmetic.  AVX2 or SSE4.1 instructions are
+ * used when the CPU supports them, with identical results to the scalar version.
+ *
+ *   @param qp  Pointer to the bank.
+ *   @param samples  The samples to be filtered.
+ *   @param n  The number of samples.
+ */
+void goertzel_qbank_run(GOERTZEL_QBANK *qp, const int16_t *samples, size_t n);
+
+/*
+ * Convert the state of each filter in the bank back to floating point and
+ * store it into an array of GOERTZEL_STATE structures, so that the final
+ * iteration can be carried out by goertzel_strength or goertzel_plan_strength.
+ * Only the state variables are stored; N, k, A and B are left as they were.
+ *
+ *   @param qp  Pointer to the bank.
+ *   @param states  Array of GOERTZEL_BANK_SIZE structures to receive the state.
+ */
+void goertzel_qbank_store(GOERTZEL_QBANK *qp, GOERTZEL_STATE *states);
+
+#endif
@@ -0,0 +1,60 @@
+#ifndef GOERTZEL_PLAN_H
+#define GOERTZEL_PLAN_H
+
+#include <stdint.h>
+
+#include "goertzel.h"
+
+/*
+ * Precomputed constants for running the Goertzel algorithm with a particular
+ * number of samples N and frequency index k.  Everything that goertzel_init and
+ * goertzel_strength compute with trigonometric functions or pow depends only on
+ * (N, k), so it is computed once here and then reused for every block of N samples
+ * that is analyzed at that frequency, rather than being recomputed for each block.
+ * See goertzel.h for the meaning of N, k, A and B.
+ */
+typedef struct goertzel_plan {
+    uint32_t N;
+    double k;
+    double A;
+    double B;
+    double cos_G;     // cos(G), where G = A * (N - 1).
+    double cos_AG;    // cos(A + G).
+    double sin_G;     // sin(G).
+    double sin_AG;    // sin(A + G).
+    double inv_N2;    // 1 / N^2, the normalization applied to the strength.
+} GOERTZEL_PLAN;
+
+/*
+ * Compute the constants of a Goertzel plan.
+ *
+ *   @param pp  Pointer to the plan to be initialized.
+ *   @param N  Number of samples in the signal to be analyzed.
+ *   @param k  Real-valued "index" of the frequency component whose strength
+ *   is to be computed, as for goertzel_init.
+ */
+void goertzel_plan_init(GOERTZEL_PLAN *pp, uint32_t N, double k);
+
+/*
+ * Initialize the state of an instance of the Goertzel algorithm from a plan.
+ * The result is the same as goertzel_init(gp, pp->N, pp->k), but without any
+ * trigonometric function calls.
+ *
+ *   @param pp  Pointer to the plan.
+ *   @param gp  Pointer to the state to be initialized.
+ */
+void goertzel_plan_start(const GOERTZEL_PLAN *pp, GOERTZEL_STATE *gp);
+
+/*
+ * Perform the final iteration of the Goertzel algorithm and return the strength
+ * of the frequency component, as for goertzel_strength, but using the constants
+ * from the plan instead of calling trigonometric functions and pow.
+ *
+ *   @param pp  Pointer to the plan with which gp was started.
+ *   @param gp  Pointer to the algorithm state.
+ *   @param x  The last sample of the signal; i.e. the sample at index N-1.
+ *   @return  The "strength" 2|y|^2 / N^2 of the frequency component.
+ */
+double goertzel_plan_strength(const GOERTZEL_PLAN *pp, GOERTZEL_STATE *gp, double x);
+
+#endif
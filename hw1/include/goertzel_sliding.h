@@ -0,0 +1,75 @@
+#ifndef GOERTZEL_SLIDING_H
+#define GOERTZEL_SLIDING_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "goertzel_bank.h"
+#include "goertzel_plan.h"
+
+/*
+ * Maximum window length supported by a sliding bank.
+ */
+#define GOERTZEL_SLIDING_MAX_N 1000
+
+/*
+ * Number of passes through the window between exact recomputations of the
+ * transforms, which discard any rounding error accumulated by the recursion.
+ */
+#define GOERTZEL_SLIDING_RESYNC 256
+
+/*
+ * A bank of sliding DFT filters, one for each frequency of a Goertzel bank.
+ * Where a Goertzel filter analyzes one block of N samples and must then be
+ * restarted, a sliding filter maintains the DTFT Y of the most recent N samples
+ * as each new sample arrives:
+ *
+ *   Y(n) = e^{jA} * (Y(n-1) - x(n-N)) + x(n) * e^{-jA(N-1)}
+ *
+ * so that windows that overlap by all but a few samples can be analyzed at a cost
+ * proportional to the hop between them rather than to N.  |Y| is the same as the
+ * |y| computed by a Goertzel filter over the same N samples, so the strengths
+ * are directly comparable.
+ */
+typedef struct goertzel_sliding {
+    uint32_t N;                                  // Window length.
+    uint32_t pos;                                // Position of the oldest sample in the window.
+    uint32_t passes;                             // Passes through the window since the last resync.
+    double re[GOERTZEL_BANK_SIZE];               // Real and imaginary parts of Y,
+    double im[GOERTZEL_BANK_SIZE];               // for each frequency.
+    double rot_re[GOERTZEL_BANK_SIZE];           // e^{jA}
+    double rot_im[GOERTZEL_BANK_SIZE];
+    double in_re[GOERTZEL_BANK_SIZE];            // e^{-jA(N-1)}
+    double in_im[GOERTZEL_BANK_SIZE];
+    double inv_N2[GOERTZEL_BANK_SIZE];           // 1 / N^2, from the plans.
+    double window[GOERTZEL_SLIDING_MAX_N];       // The last N samples, scaled to [-1, 1].
+} GOERTZEL_SLIDING;
+
+/*
+ * Initialize a sliding bank from the Goertzel plans for each of its frequencies.
+ * The window is initially filled with zeros.
+ *
+ *   @param sp  Pointer to the bank to be initialized.
+ *   @param plans  Array of GOERTZEL_BANK_SIZE plans, all with the same N, which
+ *   must not exceed GOERTZEL_SLIDING_MAX_N.
+ */
+void goertzel_sliding_init(GOERTZEL_SLIDING *sp, const GOERTZEL_PLAN *plans);
+
+/*
+ * Slide the window forward over n samples of PCM16 input.
+ *
+ *   @param sp  Pointer to the bank.
+ *   @param samples  The new samples.
+ *   @param n  The number of samples.
+ */
+void goertzel_sliding_run(GOERTZEL_SLIDING *sp, const int16_t *samples, size_t n);
+
+/*
+ * Compute the strength 2|Y|^2 / N^2 of each frequency over the current window.
+ *
+ *   @param sp  Pointer to the bank.
+ *   @param strengths  Array of GOERTZEL_BANK_SIZE values to receive the strengths.
+ */
+void goertzel_sliding_strengths(GOERTZEL_SLIDING *sp, double *strengths);
+
+#endif
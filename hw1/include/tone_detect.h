@@ -0,0 +1,30 @@
+#ifndef TONE_DETECT_H
+#define TONE_DETECT_H
+
+#include <stdio.h>
+
+#include "dtmf_detector.h"
+#include "tone_family.h"
+
+/*
+ * Detect the tones of several families in one pass over the audio.  There is one
+ * detector per family, each with the block size of its family (or of cfg, for a
+ * family that has none), and every buffer of samples read is fed to each of them
+ * in turn while it is still in the cache.  Each event is written as a line in the
+ * usual tab-separated format, prefixed by the name of its family and a tab.
+ * Events are written as they are completed, so the lines for different families
+ * are interleaved in order of detection.
+ *
+ * The audio header must already have been read from audio_in.
+ *
+ *   @param audio_in  Input stream, positioned at the start of the sample data.
+ *   @param cfg  Detector parameters; block_size is used for families without a
+ *   block size of their own, and family is ignored.
+ *   @param families  Bitmap of the families to detect, with bit i set for the
+ *   family numbered i (see tone_family.h).
+ *   @param events_out  Stream to which to write the events.
+ *   @return  0 if successful, EOF if a detector could not be created.
+ */
+int tone_detect(FILE *audio_in, const DTMF_DETECTOR_CONFIG *cfg, int families, FILE *events_out);
+
+#endif
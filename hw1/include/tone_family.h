@@ -0,0 +1,98 @@
+#ifndef TONE_FAMILY_H
+#define TONE_FAMILY_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "goertzel_bank.h"
+#include "goertzel_plan.h"
+
+/*
+ * A family of dual tones, of which DTMF is one, described by a table rather than
+ * by code, so that the same detector can look for any of them.  Each tone of a
+ * family is a pair of its frequencies.  The frequencies are either divided into a
+ * low group and a high group, with each tone taking one from each (as for DTMF), or
+ * form a single group, with each tone taking any two of them (as for MF R1).
+ *
+ * The decision for a block follows dtmf_classify_strengths: the strongest component
+ * of each group (or the two strongest components of the single group) must together
+ * reach MINUS_20DB, must be within a factor of twist of each other, and must each be
+ * stronger by a factor of margin than every other component of its group (of the
+ * single group, the weaker of the two must be).  The pair must then be one of the
+ * tones of the family.  The threshold is the same for every family, so that the
+ * energy gate of dtmf_block_quiet applies to all of them.
+ *
+ * Families are not told apart from one another: some DTMF and MF R1 tones differ by
+ * only a few Hz in each component (DTMF 3 is 697 + 1477 Hz, MF 7 is 700 + 1500 Hz),
+ * and each detector reports whatever matches its own table.
+ */
+typedef struct tone_family {
+    const char *name;     // Name of the family, as given to -T.
+    int nfreqs;           // Number of frequencies, at most GOERTZEL_BANK_SIZE.
+    int split;            // Number of frequencies in the low group, or 0 for a single group.
+    int block_size;       // Block size needed to resolve the frequencies, or 0 for any.
+    double twist;         // Largest ratio allowed between the two components.
+    double margin;        // Smallest ratio allowed between a component and the rest of its group.
+    int freqs[GOERTZEL_BANK_SIZE];                          // Frequencies, in Hz.
+    uint8_t symbols[GOERTZEL_BANK_SIZE][GOERTZEL_BANK_SIZE]; // Symbol of each pair i < j, or 0.
+} TONE_FAMILY;
+
+/*
+ * The predefined families, as numbered for tone_family_get.
+ */
+#define TONE_FAMILY_DTMF 0  // DTMF, with the symbols of dtmf_symbol_names.
+#define TONE_FAMILY_CPT  1  // North American call progress tones: D (dial), R (ringback), B (busy/reorder).
+#define TONE_FAMILY_MF   2  // MF R1: the digits, K (KP), S (ST), and P, Q, R (ST', ST'', ST''').
+#define NUM_TONE_FAMILIES 3
+
+/*
+ * Get one of the predefined families.
+ *
+ *   @param id  The number of the family, in [0, NUM_TONE_FAMILIES).
+ *   @return  The family.
+ */
+const TONE_FAMILY *tone_family_get(int id);
+
+/*
+ * Look up a predefined family by name.
+ *
+ *   @param name  The name, which need not be null-terminated.
+ *   @param length  The length of the name.
+ *   @return  The number of the family, or -1 if there is none of that name.
+ */
+int tone_family_find(const char *name, size_t length);
+
+/*
+ * Compute the Goertzel plans for the frequencies of a family at block size N.
+ * A bank always has GOERTZEL_BANK_SIZE filters; any beyond the frequencies of the
+ * family repeat the last of them, and their strengths are ignored.
+ *
+ *   @param plans  Array of GOERTZEL_BANK_SIZE plans to be initialized.
+ *   @param fp  The family.
+ *   @param N  The block size.
+ */
+void tone_plans_init(GOERTZEL_PLAN *plans, const TONE_FAMILY *fp, int N);
+
+/*
+ * Decide which tone of a family, if any, is present in a block, given the strengths
+ * of each of its frequencies in that block.  For the DTMF family the result is the
+ * same as that of dtmf_classify_strengths.
+ *
+ *   @param fp  The family.
+ *   @param strengths  Array of strengths, in the order of fp -> freqs.
+ *   @return  The symbol of the tone, or 0 if no tone is present.
+ */
+int tone_family_classify(const TONE_FAMILY *fp, const double *strengths);
+
+/*
+ * Measure the power of a tone of a family in a block: the sum of the strengths of
+ * its two frequencies.
+ *
+ *   @param fp  The family.
+ *   @param strengths  The strengths of each of its frequencies in the block.
+ *   @param symbol  The symbol of the tone.
+ *   @return  The power of the tone, or 0 if it is not one of the family.
+ */
+double tone_family_power(const TONE_FAMILY *fp, const double *strengths, uint8_t symbol);
+
+#endif
@@ -1,7 +1,11 @@
 #include <stdio.h>
+#include <stddef.h>
+#include <stdint.h>
 
 #include "audio.h"
+#include "audio_io.h"
 #include "debug.h"
+#include "dtmf_decimator.h"
 
 int readIn(FILE *in) {
 	uint32_t total = 0;
@@ -29,25 +33,34 @@ int audio_read_header(FILE *in, AUDIO_HEADER *hp) { // end of file error feof()
 	}
 	hp -> data_size = readIn(in);
 	hp -> encoding = readIn(in);
-	if (hp -> encoding != PCM16_ENCODING) {
+	if (hp -> encoding != PCM16_ENCODING && hp -> encoding != ULAW_ENCODING
+	    && hp -> encoding != ALAW_ENCODING) {
 		return EOF;
 	}
 	hp -> sample_rate = readIn(in);
-	if (hp -> sample_rate != AUDIO_FRAME_RATE) {
+	if (!dtmf_decimator_supported(hp -> sample_rate)) {
 		return EOF;
 	}
 	hp -> channels = readIn(in);
-	if (hp -> channels != AUDIO_CHANNELS) {
+	if (hp -> channels < 1 || hp -> channels > AUDIO_MAX_CHANNELS) {
 		return EOF;
 	}
 	if (hp -> data_offset == AUDIO_DATA_OFFSET) { // if offset is 24 return
 		return 0;
 	}
-	int annotation = hp -> data_offset - AUDIO_DATA_OFFSET;
-    //("%d\n", annotation);
-	while (annotation != 0) {
-		fgetc(in);
-        annotation--;
+	long annotation = hp -> data_offset - AUDIO_DATA_OFFSET;
+	// Seekable input: skip the whole annotation at once.
+	if (fseek(in, annotation, SEEK_CUR) == 0) {
+		return 0;
+	}
+	// Pipe or terminal: discard the annotation in bulk reads instead.
+	char skip[AUDIO_IO_BUF_SIZE];
+	while (annotation > 0) {
+		size_t chunk = annotation < AUDIO_IO_BUF_SIZE ? annotation : AUDIO_IO_BUF_SIZE;
+		if (fread(skip, 1, chunk, in) != chunk) {
+			return EOF;
+		}
+		annotation -= chunk;
 	}
     return 0;
 }
@@ -92,3 +105,116 @@ int audio_write_sample(FILE *out, int16_t sample) {
     fputc((sample & 0xFF), out);
     return 0;
 }
+
+/*
+ * Convert a 16-bit value between big-endian (file) byte order and host byte order.
+ * The conversion is its own inverse, so it is used in both directions.
+ */
+static inline uint16_t swap_be16(uint16_t v) {
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    return __builtin_bswap16(v);
+#else
+    return v;
+#endif
+}
+
+void audio_decode_samples(int16_t *samples, size_t n) {
+    uint16_t *p = (uint16_t *)samples;
+    for (size_t i = 0; i < n; i++) {
+        *(p + i) = swap_be16(*(p + i));
+    }
+}
+
+void audio_encode_samples(int16_t *samples, size_t n) {
+    // Byte swapping is its own inverse.
+    audio_decode_samples(samples, n);
+}
+
+size_t audio_read_samples(FILE *in, int16_t *samples, size_t n) {
+    if (in == NULL || samples == NULL) {
+        return 0;
+    }
+    // Read straight into the caller's buffer, then fix up the byte order in place.
+    size_t count = fread(samples, AUDIO_BYTES_PER_SAMPLE, n, in);
+    audio_decode_samples(samples, count);
+    return count;
+}
+
+/*
+ * Expansion tables for the G.711 encodings, computed at startup from the
+ * segmented (sign, exponent, mantissa) form of each code as in ITU-T G.711.
+ */
+static int16_t ulaw_table[256];
+static int16_t alaw_table[256];
+
+__attribute__((constructor))
+static void audio_init_tables(void) {
+    for (int code = 0; code < 256; code++) {
+        // mu-law codes are stored complemented; the magnitude is biased by 0x84.
+        int u = ~code & 0xFF;
+        int t = (((u & 0x0F) << 3) + 0x84) << ((u & 0x70) >> 4);
+        *(ulaw_table + code) = (int16_t)((u & 0x80) ? 0x84 - t : t - 0x84);
+        // A-law codes have their even bits inverted, and a sign bit of 1 for positive.
+        int a = code ^ 0x55;
+        int seg = (a & 0x70) >> 4;
+        int m = (a & 0x0F) << 4;
+        m = seg == 0 ? m + 8 : (m + 0x108) << (seg - 1);
+        *(alaw_table + code) = (int16_t)((a & 0x80) ? m : -m);
+    }
+}
+
+size_t audio_sample_size(uint32_t encoding) {
+    return encoding == ULAW_ENCODING || encoding == ALAW_ENCODING ? 1 : AUDIO_BYTES_PER_SAMPLE;
+}
+
+void audio_expand_samples(uint32_t encoding, const void *data, int16_t *samples, size_t n) {
+    const uint8_t *p = data;
+    if (encoding == ULAW_ENCODING || encoding == ALAW_ENCODING) {
+        // From the end backwards, so that no code is overwritten before it is expanded.
+        const int16_t *table = encoding == ULAW_ENCODING ? ulaw_table : alaw_table;
+        for (size_t i = n; i > 0; i--) {
+            *(samples + i - 1) = *(table + *(p + i - 1));
+        }
+        return;
+    }
+    for (size_t i = 0; i < n; i++) {
+        *(samples + i) = (int16_t)((*(p + 2 * i) << 8) | *(p + 2 * i + 1));
+    }
+}
+
+size_t audio_read_encoded(FILE *in, uint32_t encoding, int16_t *samples, size_t n) {
+    if (audio_sample_size(encoding) == AUDIO_BYTES_PER_SAMPLE) {
+        return audio_read_samples(in, samples, n);
+    }
+    if (in == NULL || samples == NULL) {
+        return 0;
+    }
+    // Read the codes into the front of the buffer and expand them in place.
+    size_t count = fread(samples, 1, n, in);
+    audio_expand_samples(encoding, samples, samples, count);
+    return count;
+}
+
+size_t audio_write_samples(FILE *out, const int16_t *samples, size_t n) {
+    if (out == NULL || samples == NULL) {
+        return 0;
+    }
+    // Encode through a bounded staging buffer, since the caller's samples are const.
+    uint16_t buf[AUDIO_IO_BUF_SIZE / AUDIO_BYTES_PER_SAMPLE];
+    size_t done = 0;
+    while (done < n) {
+        size_t chunk = n - done;
+        if (chunk > AUDIO_IO_BUF_SIZE / AUDIO_BYTES_PER_SAMPLE) {
+            chunk = AUDIO_IO_BUF_SIZE / AUDIO_BYTES_PER_SAMPLE;
+        }
+        for (size_t i = 0; i < chunk; i++) {
+            *(buf + i) = swap_be16((uint16_t)*(samples + done + i));
+        }
+        size_t wrote = fwrite(buf, AUDIO_BYTES_PER_SAMPLE, chunk, out);
+        done += wrote;
+        if (wrote != chunk) {
+            break;
+        }
+    }
+    return done;
+}
@@ -1,12 +1,29 @@
 #include <stdint.h>
 #include <stdlib.h>
 #include <math.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/stat.h>
 
 #include "const.h"
 #include "audio.h"
+#include "audio_io.h"
 #include "dtmf.h"
+#include "dtmf_options.h"
 #include "dtmf_static.h"
-#include "goertzel.h"
+#include "dtmf_detector.h"
+#include "dtmf_generator.h"
+#include "dtmf_parallel.h"
+#include "dtmf_batch.h"
+#include "dtmf_refine.h"
+#include "dtmf_pipeline.h"
+#include "dtmf_channels.h"
+#include "dtmf_sidecar.h"
+#include "dtmf_sweep.h"
+#include "tone_detect.h"
+#include "dtmf_script.h"
 #include "debug.h"
 
 #ifdef _STRING_H
@@ -34,6 +51,109 @@
  * IF YOU VIOLATE THIS RESTRICTION, YOU WILL GET A ZERO!
  */
 
+/*
+ * Minimum length (in samples) of a run of zeros that is skipped over with a seek,
+ * rather than written, when the output is sparse.
+ */
+#define SPARSE_MIN_RUN 32768
+
+/*
+ * Check whether runs of zeros can be left as holes in the output: that is,
+ * whether it is a regular file, so that it can be seeked, and is not opened for
+ * appending, which would place the next write at the end rather than after the hole.
+ */
+static int sparse_ok(FILE *audio_out) {
+	struct stat st;
+	int flags = fcntl(fileno(audio_out), F_GETFL);
+	return flags != -1 && !(flags & O_APPEND)
+	    && fstat(fileno(audio_out), &st) == 0 && S_ISREG(st.st_mode);
+}
+
+/*
+ * Write count zero samples.  If sparse is set and the run is long, and it lies
+ * beyond the current end of the output file, it is skipped over with a seek,
+ * which leaves a hole that reads as zeros and takes no space.  Otherwise the
+ * zeros are written in chunks of SAMPLE_BUF_SIZE.
+ */
+static void write_zeros(FILE *audio_out, int count, int sparse) {
+	if (sparse && count >= SPARSE_MIN_RUN && fflush(audio_out) == 0) {
+		struct stat st;
+		off_t pos = ftello(audio_out);
+		if (pos != -1 && fstat(fileno(audio_out), &st) == 0 && pos >= st.st_size
+		    && fseeko(audio_out, (off_t)count * AUDIO_BYTES_PER_SAMPLE, SEEK_CUR) == 0) {
+			return;
+		}
+	}
+	for (int i = 0; i < SAMPLE_BUF_SIZE && i < count; i++) {
+		*(sample_buf + i) = 0;
+	}
+	while (count > 0) {
+		int n = count < SAMPLE_BUF_SIZE ? count : SAMPLE_BUF_SIZE;
+		fwrite(sample_buf, AUDIO_BYTES_PER_SAMPLE, n, audio_out);
+		count -= n;
+	}
+}
+
+/*
+ * Write count samples of the tone for the specified DTMF symbol (or of silence,
+ * if symbol is 0), as produced by a generator, in chunks of at most SAMPLE_BUF_SIZE.
+ * Silence that is known to be all zeros is written by write_zeros.
+ */
+static int write_samples(FILE *audio_out, DTMF_GENERATOR *gp, uint8_t symbol, int count, int sparse) {
+	while (count > 0) {
+		if (symbol == 0 && dtmf_generator_silent(gp)) {
+			dtmf_generator_skip(gp, count);
+			write_zeros(audio_out, count, sparse);
+			break;
+		}
+		int n = count < SAMPLE_BUF_SIZE ? count : SAMPLE_BUF_SIZE;
+		if (dtmf_generator_render(gp, symbol, sample_buf, n) == EOF) {
+			return EOF;
+		}
+		audio_write_samples(audio_out, sample_buf, n);
+		count -= n;
+	}
+	return 0;
+}
+
+/*
+ * If the output ends with a hole, the file must be extended to its full length,
+ * since nothing was written at the end.
+ */
+static void finish_sparse(FILE *audio_out) {
+	struct stat st;
+	fflush(audio_out);
+	off_t pos = ftello(audio_out);
+	if (pos != -1 && fstat(fileno(audio_out), &st) == 0 && st.st_size < pos) {
+		if (ftruncate(fileno(audio_out), pos) == -1) {
+			debug("ftruncate failed");
+		}
+	}
+}
+
+/*
+ * Where the samples of a script go as its events are read, and how far they have got.
+ */
+typedef struct script_writer {
+	FILE *audio_out;
+	DTMF_GENERATOR *gp;
+	int sparse;
+	uint32_t end;  // Index of the next sample to be written.
+} SCRIPT_WRITER;
+
+/*
+ * Write the samples up to the end of each of the events just read, one event at a time.
+ */
+static void write_events(void *arg, const DTMF_SCRIPT *sp) {
+	SCRIPT_WRITER *wp = arg;
+	for (size_t i = 0; i < sp -> count; i++) {
+		DTMF_EVENT *ep = sp -> events + i;
+		write_samples(wp -> audio_out, wp -> gp, 0, ep -> start - wp -> end, wp -> sparse);
+		write_samples(wp -> audio_out, wp -> gp, ep -> symbol, ep -> end - ep -> start, wp -> sparse);
+		wp -> end = ep -> end;
+	}
+}
+
 /**
  * DTMF generation main function.
  * DTMF events are read (in textual tab-separated format) from the specified
@@ -45,6 +165,12 @@
  * it will be a synthesized sample of the DTMF tone corresponding to the event in
  * which the index lies.
  *
+ * The samples for the events in each block of input are written as soon as the block
+ * has been read.  If num_jobs is greater than one and the output is a regular file,
+ * then the events are instead read in full, and the output is divided into segments
+ * that are synthesized and written by num_jobs threads at once, with the same result
+ * (see dtmf_parallel.h).
+ *
  *  @param events_in  Stream from which to read DTMF events.
  *  @param audio_out  Stream to which to write audio header and sample data.
  *  @param length  Number of audio samples to be written.
@@ -63,179 +189,86 @@ int dtmf_generate(FILE *events_in, FILE *audio_out, uint32_t length) {
     hp.sample_rate = 8000;
     hp.channels = 0x1;
     audio_write_header(audio_out, &hp);
-   	int e = 0;
-   	int noise_exist = 0;
-   	FILE* noise = NULL;
-   	int16_t noise_sample = 0;
-   	if (noise_file != NULL) {
-   		noise = fopen(noise_file, "r");
-   		noise_exist = 1;
-   		int temp = audio_read_header(noise, &hp);
-   		if (temp == EOF) {
-   			return EOF;
-   		}
-   		//printf("%d\n", h.data_offset);
-   	}
-   	while(fgets(line_buf, LINE_BUF_SIZE, events_in)) {
-   		int start = 0;
-   		int end = 0;
-   		int count = 0;
-   		while (*(line_buf + count) != '\t') {
-   			start += *(line_buf + count) - 48;
-   			count++;
-   			if (*(line_buf + count) == '\t') {
-   				count++;
-   				break;
-   			}
-   			start = start * 10;
-   		}
-	    	// printf("start is %d\n", start);
-   		while (*(line_buf + count) != '\t') {
-   			end += *(line_buf + count) - 48;
-   			count++;
-   			if (*(line_buf + count) == '\t') {
-   				count++;
-   				break;
-   			}
-   			end = end * 10;
-   		}
-	    	// printf("end is %d\n", end);
-   		if (e > start || start >= end) {
-   			fprintf(stderr, "Overlapping error\n");
-   			return EOF;
-   		}
-   		if (start >= length) {
-   			break;
-   		}
-   		int zeros = start - e;
-   		while (zeros > 0) {
-   			if (noise_exist) {
-   				if (audio_read_sample(noise, &noise_sample) == EOF) {
-   					audio_write_sample(audio_out, 0);
-   				} else {
-   					double w = pow(10, 0.1 * noise_level) / (pow(10, 0.1 * noise_level) + 1);
-   					int16_t combine = (int16_t) (w * noise_sample);
-   					audio_write_sample(audio_out, combine);
-   				}
-   			} else {
-   				audio_write_sample(audio_out, 0);
-   			}
-   			zeros--;
-   		}
-   		e = end;
-   		char symbol = *(line_buf + count);
-	    	// printf("%c\n", symbol);
-   		int r = -1;
-   		int c = -1;
-   		for (int i = 0; i < NUM_DTMF_ROW_FREQS; i++) {
-   			for (int j = 0; j < NUM_DTMF_COL_FREQS; j++) {
-   				if (*(*(dtmf_symbol_names + i) + j) == symbol) {
-   					r = i;
-   					c = j;
-   					break;
-   				}
-   			}
-   			if (r != -1 || c != -1) {
-   				break;
-   			}
-   		}
-	    	// printf("Fr is %d, Fc is %d\n", Fr, Fc);
-   		if (r == -1 || c == -1) {
-   			return EOF;
-   		}
-   		int Fr = *(dtmf_freqs + r);
-   		int Fc = *(dtmf_freqs + NUM_DTMF_ROW_FREQS + c);
-	    	// printf("s: %d, e: %d, Fr %d, Fc %d\n", start, end, Fr, Fc);
-   		for (int i = start; i < end && i < length; i++) {
-   			double a = cos(2.0 * M_PI * Fr * i / AUDIO_FRAME_RATE);
-   			double b = cos(2.0 * M_PI * Fc * i / AUDIO_FRAME_RATE);
-   			int16_t sample = (int16_t)((a + b) * 0.5 * INT16_MAX);
-   			if (noise_exist) {
-   				if (audio_read_sample(noise, &noise_sample) == EOF) { // This function returns zero if successful, or else it returns a non-zero value.
-   					double w = pow(10, 0.1 * noise_level) / (pow(10, 0.1 * noise_level) + 1);
-   					int16_t combine = (int16_t) ((a + b) * 0.5 * INT16_MAX * (1 - w));
-   					audio_write_sample(audio_out, combine);
-   				} else {
-   					double w = pow(10, 0.1 * noise_level) / (pow(10, 0.1 * noise_level) + 1);
-   					int16_t combine = (int16_t) (w * noise_sample + (a + b) * 0.5 * INT16_MAX * (1 - w));
-   					audio_write_sample(audio_out, combine);
-   				}
-   			} else {
-   				audio_write_sample(audio_out, sample);
-   			}
-   		}
-   		if (end >= length) {
-   			e = length;
-   			break;
-   		}
-   	}
-   	while (e < length) {
-   		if (noise_exist) {
-   			if (audio_read_sample(noise, &noise_sample) == EOF) { // This function returns zero if successful, or else it returns a non-zero value.
-   				audio_write_sample(audio_out, 0);
-  			} else {
-   				double w = pow(10, 0.1 * noise_level) / (pow(10, 0.1 * noise_level) + 1);
-   				int16_t combine = (int16_t) (w * noise_sample);
-   				audio_write_sample(audio_out, combine);
-   			}
-   		} else {
-   			audio_write_sample(audio_out, 0);
-   		}
-  		e++;
-   	}
-   	return 0;
-}
-
-int findStrong(int* row_index, int* col_index, double* strong_row, double* strong_col) {
-	for (int i = 0; i < 4; i++) {
-		if (*(goertzel_strengths + i) > *strong_row) {
-			*strong_row = *(goertzel_strengths + i);
-			*row_index = i;
-		}
-		if (*(goertzel_strengths + i + 4) > *strong_col) {
-			*strong_col = *(goertzel_strengths + i + 4);
-			*col_index = i;
-		}
-	}
-	return 0;
+    DTMF_NOISE *noise = NULL;
+    if (noise_file != NULL && (noise = dtmf_noise_open(noise_file)) == NULL) {
+    	return EOF;
+    }
+    DTMF_GENERATOR_CONFIG cfg = { .noise = noise, .noise_level = noise_level };
+    DTMF_SCRIPT script;
+    dtmf_script_init(&script);
+    int ret = 0;
+    if (num_jobs > 1 && sparse_ok(audio_out)) {
+    	ret = dtmf_script_read(&script, events_in, length);
+    	if (dtmf_generate_parallel(audio_out, &script, &cfg, num_jobs) == EOF) {
+    		ret = EOF;
+    	}
+    } else {
+    	SCRIPT_WRITER writer = {
+    		.audio_out = audio_out, .gp = dtmf_generator_new(&cfg), .sparse = sparse_ok(audio_out)
+    	};
+    	if (writer.gp != NULL) {
+    		ret = dtmf_script_stream(&script, events_in, length, write_events, &writer);
+    		write_samples(audio_out, writer.gp, 0, script.length - writer.end, writer.sparse);
+    		if (writer.sparse) {
+    			finish_sparse(audio_out);
+    		}
+    	} else {
+    		ret = EOF;
+    	}
+    	dtmf_generator_free(writer.gp);
+    }
+    dtmf_script_free(&script);
+    dtmf_noise_close(noise);
+    return ret;
 }
 
-int checkSixDB(int row_index, int col_index) {
-	for (int i = 0; i < NUM_DTMF_ROW_FREQS; i++) {
-    	if ((i != row_index) && (*(goertzel_strengths + row_index) < *(goertzel_strengths + i) * SIX_DB)) {
-    		return 0;
-   		}
-   		if ((i != col_index) && (*(goertzel_strengths + 4 + col_index) < *(goertzel_strengths + i + 4) * SIX_DB)) {
-    		return 0;
-    	}
-   	}
-   	return 1;
+/*
+ * Event reporting function for streaming mode, which pushes each line out to
+ * the reader as soon as it is written.
+ */
+static void print_event_flush(void *arg, int start, int end, uint8_t symbol) {
+	dtmf_event_print(arg, start, end, symbol);
+	fflush(arg);
 }
 
-int goertzel_generate(FILE* audio_in, int N) {
-	for (int F = 0; F < NUM_DTMF_FREQS; F++) {
-		double k = *(dtmf_freqs + F) * N * 1.0 / AUDIO_FRAME_RATE;
-		goertzel_init(goertzel_state + F, N, k);
+/*
+ * Streaming detection: read whatever sample data is available, without waiting
+ * for a full block or a full stdio buffer, and feed it to incremental detection
+ * at once.  When no data is available, wait for more with poll.
+ */
+static int detect_stream(FILE *audio_in, uint32_t encoding, DTMF_DETECTOR *dp, FILE *events_out) {
+	int fd = fileno(audio_in);
+	size_t size = audio_sample_size(encoding);
+	int flags = fcntl(fd, F_GETFL);
+	if (flags == -1 || fcntl(fd, F_SETFL, flags | O_NONBLOCK) == -1) {
+		return EOF;
 	}
-	int16_t sample;
-	for(int i = 0; i < N-1; i++) {
-		int temp = audio_read_sample(audio_in, &sample);
-		if (temp == EOF) {
-			return 0;
-		}
-		for (int F = 0; F < NUM_DTMF_FREQS; F++) {
-			goertzel_step(goertzel_state + F, (double)sample / INT16_MAX);
+	char *bytes = (char *)sample_buf;
+	size_t have = 0;  // bytes in the buffer: at most a single odd byte between reads
+	int ret = 0;
+	while (1) {
+		ssize_t r = read(fd, bytes + have, SAMPLE_BUF_SIZE * size - have);
+		if (r > 0) {
+			have += r;
+			size_t n = have / size;
+			audio_expand_samples(encoding, sample_buf, sample_buf, n);
+			dtmf_detector_feed(dp, sample_buf, n, print_event_flush, events_out);
+			if (have % size) {
+				*bytes = *(bytes + have - 1);
+			}
+			have %= size;
+		} else if (r == 0) {
+			break;
+		} else if (errno == EAGAIN || errno == EWOULDBLOCK) {
+			struct pollfd pfd = { .fd = fd, .events = POLLIN };
+			poll(&pfd, 1, -1);
+		} else if (errno != EINTR) {
+			ret = EOF;
+			break;
 		}
 	}
-	int tem = audio_read_sample(audio_in, &sample);
-	if (tem == EOF) {
-		return 0;
-	}
-	for (int F = 0; F < NUM_DTMF_FREQS; F++) {
-		double r = goertzel_strength(goertzel_state + F, (double)sample / INT16_MAX);
-		*(goertzel_strengths + F) = r;
-	}
-	return 1;
+	fcntl(fd, F_SETFL, flags);
+	return ret;
 }
 
 /**
@@ -243,6 +276,17 @@ int goertzel_generate(FILE* audio_in, int N) {
  * This function first reads and validates an audio header from the specified input stream.
  * The value in the data size field of the header is ignored, as is any annotation data that
  * might occur after the header.
+ * The sample data may be 16-bit linear PCM, or G.711 mu-law or A-law, which is expanded
+ * to 16-bit samples as it is read (see audio.h).  If the audio has more than one channel,
+ * then each channel is analyzed in the same way, in the same pass over the audio, and
+ * each line of output is prefixed by the index of the channel (from 0) and a tab
+ * (see dtmf_channels.h).  This is not supported with tone_families, coarse_size,
+ * stream_mode, pipeline_mode, sidecar_file or sweep_spec, which is reported on stderr,
+ * and num_jobs is ignored.  Audio at a higher sample rate
+ * than 8000 Hz, such as a 16 kHz or 48 kHz recording, is decimated to 8000 Hz as it is read
+ * (see dtmf_decimator.h), so that block_size and hop_size are still counted in samples at
+ * 8000 Hz, but the indices of the events are those of the input samples.  This is not
+ * supported with coarse_size, and num_jobs is ignored.
  *
  * This function then reads audio sample data from the input stream, partititions the audio samples
  * into successive blocks of block_size samples, and for each block determines whether or not
@@ -259,6 +303,34 @@ int goertzel_generate(FILE* audio_in, int N) {
  * read is used as the ending index of any current DTMF event and this final event is emitted
  * if its length is at least MIN_DTMF_DURATION.
  *
+ * If hop_size is less than block_size, then instead of disjoint blocks, overlapping windows
+ * of block_size samples starting every hop_size samples are analyzed, so that event boundaries
+ * are reported with a resolution of hop_size samples (see dtmf_tracker.h).
+ *
+ * If num_jobs is greater than one and the input is a regular file, then block-by-block analysis
+ * is divided among num_jobs threads, with the same result (see dtmf_parallel.h).
+ *
+ * If batch_mode is set, then audio data is instead read from each of a number of files,
+ * either named in batch_files or listed in audio_in, and the events for each file are
+ * written to events_out or to a file of their own (see dtmf_batch.h).
+ *
+ * If stream_mode is set, then audio data is processed as soon as it arrives, and each event
+ * (and optionally, each event onset) is flushed to the output stream as soon as it is known,
+ * with the detection latency reported on stderr.
+ *
+ * If pipeline_mode is set, then reading, filtering and writing are done by separate
+ * threads, connected by lock-free queues, with the same result (see dtmf_pipeline.h).
+ *
+ * If sidecar_file is set, then the strengths of the DTMF frequencies in every block are also
+ * written to that file.  If redecide_file is set, then no audio is read; instead the blocks
+ * recorded in that file are decided again, with the thresholds in thresholds_spec, if any,
+ * and the events are written as they would have been by detection with those thresholds
+ * (see dtmf_sidecar.h).
+ *
+ * If sweep_spec is set, then the audio is instead analyzed with each of the block sizes in
+ * that list, in the same pass, and a summary of the events found with each size is
+ * written to stderr (see dtmf_sweep.h).
+ *
  *   @param audio_in  Input stream from which to read audio header and sample data.
  *   @param events_out  Output stream to which DTMF events are to be written.
  *   @return 0  If reading of audio and writing of DTMF events is sucessful, EOF otherwise.
@@ -267,57 +339,120 @@ int dtmf_detect(FILE *audio_in, FILE *events_out) {
     if (audio_in == NULL || events_out == NULL) {
     	return EOF;
     }
+    DTMF_DETECTOR_CONFIG cfg = {
+    	.block_size = block_size, .hop_size = hop_size,
+    	.engine = goertzel_engine, .flags = stream_mode
+    };
+    if (redecide_file != NULL) {
+    	DTMF_THRESHOLDS thresholds = dtmf_default_thresholds;
+    	if ((thresholds_spec != NULL && dtmf_thresholds_parse(thresholds_spec, &thresholds) == -1)
+    	    || dtmf_redecide(redecide_file, &thresholds, dtmf_event_print, events_out) == EOF) {
+    		return EOF;
+    	}
+    	fflush(events_out);
+    	return 0;
+    }
+    if (batch_mode) {
+    	return dtmf_detect_batch(batch_files, batch_count, audio_in, &cfg, num_jobs,
+    	                         batch_mode, events_out);
+    }
+    if (stream_mode || pipeline_mode) {
+    	// Leave nothing in a stdio buffer, where reads from the descriptor would not see it.
+    	setvbuf(audio_in, NULL, _IONBF, 0);
+    }
     AUDIO_HEADER hp;
     int check_header = audio_read_header(audio_in, &hp);
     if (check_header == EOF) {
     	return EOF;
     }
-    int start = -1;
-    int index = 0;
-    uint8_t tone = 0;
-    while (feof(audio_in) != EOF) {
-    	int valid = 1;
-    	int valid_block = goertzel_generate(audio_in, block_size);
-    	if (!valid_block && start != -1) {
-    		if ((double)(index - start)/8000 >= MIN_DTMF_DURATION) {
-    			fprintf(events_out, "%i\t%i\t%c\n", start, index, tone);
-    		}
-    		break;
-    	} else if (!valid_block) {
-    		break;
+    cfg.encoding = hp.encoding;
+    cfg.sample_rate = hp.sample_rate;
+    if (hp.channels > AUDIO_CHANNELS) {
+    	// Each channel has a block-by-block or sliding-window detector of its own.
+    	if (tone_families != 0 || coarse_size != 0 || stream_mode || pipeline_mode || sidecar_file
+    	    || sweep_spec != NULL) {
+    		fprintf(stderr, "Audio with %u channels cannot be analyzed with -c, -T, -s, -p, -S or -B\n",
+    		        hp.channels);
+    		return EOF;
     	}
-    	double strong_row = 0;
-    	double strong_col = 0;
-    	int row_index = 0;
-    	int col_index = 0;
-    	findStrong(&row_index, &col_index, &strong_row, &strong_col);
-    	if (strong_row + strong_col < MINUS_20DB) {
-    		valid = 0;
+    	if (dtmf_detect_channels(audio_in, &cfg, hp.channels, dtmf_channel_event_print,
+    	                         events_out) == EOF) {
+    		return EOF;
     	}
-    	double ratio = strong_row / strong_col;
-    	if (ratio > FOUR_DB || ratio < 1/FOUR_DB) {
-    		valid = 0;
+    	fflush(events_out);
+    	return 0;
+    }
+    if (sweep_spec != NULL) {
+    	if (dtmf_detect_sweep(audio_in, &cfg, sweep_spec, events_out, stderr) == EOF) {
+    		return EOF;
     	}
-    	valid = checkSixDB(row_index, col_index) ? valid : 0;
-    	if (valid && start == -1) {
-    		start = index;
-    		tone = *(*(dtmf_symbol_names + row_index) + col_index);
-    	} else if ((!valid || tone != *(*(dtmf_symbol_names + row_index) + col_index)) && start != -1) {
-    		if ((double)(index - start)/8000 >= MIN_DTMF_DURATION) {
-    			fprintf(events_out, "%i\t%i\t%c\n", start, index, tone);
-    		}
-    		if (valid && tone != *(*(dtmf_symbol_names + row_index) + col_index)) {
-    			start = index;
-    			tone = *(*(dtmf_symbol_names + row_index) + col_index);
-    		} else {
-    			start = -1;
-	    		tone = 0;
+    	fflush(events_out);
+    	return 0;
+    }
+    if (tone_families != 0) {
+    	if (tone_detect(audio_in, &cfg, tone_families, events_out) == EOF) {
+    		return EOF;
+    	}
+    	fflush(events_out);
+    	return 0;
+    }
+    if (coarse_size != 0) {
+    	// Both passes read the same samples at 8000 Hz, which decimated audio does not have.
+    	if (hp.sample_rate != AUDIO_FRAME_RATE) {
+    		fprintf(stderr, "Audio at %u Hz cannot be analyzed with -c\n", hp.sample_rate);
+    		return EOF;
+    	}
+    	if (dtmf_detect_refine(audio_in, &cfg, coarse_size, dtmf_event_print, events_out) == EOF) {
+    		return EOF;
+    	}
+    	fflush(events_out);
+    	return 0;
+    }
+    if (!stream_mode && num_jobs > 1 && !(hop_size > 0 && hop_size < block_size)
+        && hp.sample_rate == AUDIO_FRAME_RATE && dtmf_parallel_ok(audio_in)) {
+    	if (dtmf_detect_parallel(audio_in, &cfg, num_jobs, dtmf_event_print, events_out) == EOF) {
+    		return EOF;
+    	}
+    	fflush(events_out);
+    	return 0;
+    }
+    if (sidecar_file != NULL && (cfg.sidecar = dtmf_sidecar_create(sidecar_file, block_size,
+                                                                   hop_size, hp.sample_rate)) == NULL) {
+    	return EOF;
+    }
+    DTMF_DETECTOR *dp = dtmf_detector_new(&cfg);
+    if (dp == NULL) {
+    	// Leave no sidecar of a detection that never started.
+    	if (cfg.sidecar != NULL) {
+    		dtmf_sidecar_close(cfg.sidecar);
+    		unlink(sidecar_file);
+    	}
+    	return EOF;
+    }
+    int ret = 0;
+    if (pipeline_mode) {
+    	// The pipeline finishes the detector itself.
+    	ret = dtmf_detect_pipeline(audio_in, hp.encoding, dp,
+    	                           stream_mode ? print_event_flush : dtmf_event_print, events_out);
+    } else {
+    	if (stream_mode) {
+    		ret = detect_stream(audio_in, hp.encoding, dp, events_out);
+    	} else {
+    		size_t got;
+    		while ((got = audio_read_encoded(audio_in, hp.encoding, sample_buf, SAMPLE_BUF_SIZE)) > 0) {
+    			dtmf_detector_feed(dp, sample_buf, got, dtmf_event_print, events_out);
     		}
     	}
-    	index += block_size;
+    	if (ret != EOF) {
+    		dtmf_detector_finish(dp, stream_mode ? print_event_flush : dtmf_event_print, events_out);
+    	}
+    }
+    dtmf_detector_free(dp);
+    if (dtmf_sidecar_close(cfg.sidecar) == EOF) {
+    	ret = EOF;
     }
     fflush(events_out);
-    return 0;
+    return ret;
 }
 
 /**
@@ -370,6 +505,47 @@ int parse(char *a) {
 	return count;
 }
 
+/**
+ * Parse a noise level: a decimal number of dB, optionally negative, in [-30, 30].
+ * Returns -1 if it is not valid.
+ */
+int parse_level(char *a, int *levelp) {
+	int negative = 0;
+	if (*a == '-') {
+		negative = 1;
+		a++;
+	}
+	int count = parse(a);
+	if (count < 0 || count > 30) {
+		return -1;
+	}
+	*levelp = negative ? -count : count;
+	return 0;
+}
+
+/**
+ * Parse a comma-separated list of tone family names into tone_families.
+ * Returns -1 if a name is not known.
+ */
+int parse_families(char *a) {
+	tone_families = 0;
+	while (1) {
+		char *p = a;
+		while (*p != 0 && *p != ',') {
+			p++;
+		}
+		int id = tone_family_find(a, p - a);
+		if (id == -1) {
+			return -1;
+		}
+		tone_families |= 1 << id;
+		if (*p == 0) {
+			return 0;
+		}
+		a = p + 1;
+	}
+}
+
 void setH() {
 	global_options = HELP_OPTION;
 }
@@ -386,6 +562,29 @@ void setErr() {
 	global_options = 0x0;
 }
 
+/*
+ * Bits of the bitmap in which validargs records the options already given, each of
+ * which may be given at most once.
+ */
+#define SEEN_BLOCK 0x1          // -b
+#define SEEN_ENGINE 0x2         // -e
+#define SEEN_HOP 0x4            // -H
+#define SEEN_STREAM 0x8         // -s
+#define SEEN_ONSET 0x10         // -o
+#define SEEN_JOBS 0x20          // -j
+#define SEEN_LIST 0x40          // -L
+#define SEEN_WRITE 0x80         // -w
+#define SEEN_COARSE 0x100       // -c
+#define SEEN_TONES 0x200        // -T
+#define SEEN_PIPELINE 0x400     // -p
+#define SEEN_SIDECAR 0x800      // -S
+#define SEEN_REDECIDE 0x1000    // -r
+#define SEEN_THRESHOLDS 0x2000  // -x
+#define SEEN_SWEEP 0x4000       // -B
+#define SEEN_TIME 0x8000        // -t
+#define SEEN_NOISE 0x10000      // -n
+#define SEEN_LEVEL 0x20000      // -l
+
 /**
  * @brief Validates command line arguments passed to the program.
  * @details This function will validate all the arguments passed to the
@@ -417,313 +616,228 @@ int validargs(int argc, char **argv)
 		setH();
 		return 0;
 	}
-	if (argc > 8 || argc % 2 == 1) { // after -h failed and arc exceeds the limit
-		return -1;
-	}
 	if (equal(first, "-g")) {
 		noise_file = NULL;
 		noise_level = 0;
-		if (argc == 2) {
-			setG();
-			audio_samples = 8000; // Default MSEC 1000 time
-			return 0;
-		} else if (equal(*(argv + 2), "-t")) {
-			char * MSEC_string = *(argv + 3);
-			int MSEC = parse(MSEC_string);
-			if (MSEC <= UINT32_MAX && MSEC >= 0) { // MSEC <= UINT32_MAX && 2,147,483,647 / 8
+		audio_samples = 8000; // Default MSEC 1000 time
+		num_jobs = 1;
+		int seen = 0; // bitmap of options already given
+		// -t, -n, -l and -j at most once each, in any order, with arguments.
+		for (int i = 2; i < argc; i += 2) {
+			if (i + 1 >= argc) {
+				return -1;
+			}
+			char *opt = *(argv + i);
+			char *arg = *(argv + i + 1);
+			if (equal(opt, "-t") && !(seen & SEEN_TIME)) {
+				int MSEC = parse(arg);
+				if (MSEC < 0) {
+					return -1;
+				}
 				audio_samples = MSEC * 8;
 				if (audio_samples < 0) {
 					return -1;
 				}
-				if (argc == 4) {
-					setG();
-					return 0;
-				} else if (equal(*(argv + 4), "-n")) {
-					noise_file = *(argv + 5);
-					if (argc == 6) {
-						setG();
-						return 0;
-					} else if (equal(*(argv + 6), "-l")) {
-						char * level = *(argv + 7);
-						int bool = 0; // is negative?
-						if (*level == 45) {
-							bool = 1;
-							level++;
-						}
-						int count = 0;
-						while (*level != 0) {
-							int num = *level - '0';
-							if (num < 0 || num > 9) {
-								return -1;
-							}
-							count += num;
-							level++;
-							if (*level == 0) {
-								break;
-							}
-							count = count * 10;
-						}
-						if (bool) {
-							count = 0 - count;
-						}
-						if (count >= -30 && count <= 30) {
-							noise_level = count;
-							setG();
-							return 0;
-						} else {
-							return -1;
-						}
-					} else {
-						return -1;
-					}
-				} else if (equal(*(argv + 4), "-l")) { // l and n
-					char * level = *(argv + 5);
-					int bool = 0; // is negative?
-					if (*level == 45) {
-						bool = 1;
-						level++;
-					}
-					int count = 0;
-					while (*level != 0) {
-						int num = *level - '0';
-						if (num < 0 || num > 9) {
-							return -1;
-						}
-						count += num;
-						level++;
-						if (*level == 0) {
-							break;
-						}
-						count = count * 10;
-					}
-					if (bool) {
-						count = 0 - count;
-					}
-					if (count >= -30 && count <= 30) {
-						noise_level = count;
-						if (argc == 6) {
-							setG();
-							return 0;
-						} else if (equal(*(argv + 6), "-n")) {
-							noise_file = *(argv + 7);
-							setG();
-							return 0;
-						} else {
-							return -1;
-						}
-					} else {
-						return -1;
-					}
-				} else {
+				seen |= SEEN_TIME;
+			} else if (equal(opt, "-n") && !(seen & SEEN_NOISE)) {
+				noise_file = arg;
+				seen |= SEEN_NOISE;
+			} else if (equal(opt, "-l") && !(seen & SEEN_LEVEL)) {
+				if (parse_level(arg, &noise_level) == -1) {
+					return -1;
+				}
+				seen |= SEEN_LEVEL;
+			} else if (equal(opt, "-j") && !(seen & SEEN_JOBS)) {
+				num_jobs = parse(arg);
+				if (num_jobs < 1 || num_jobs > MAX_JOBS) {
 					return -1;
 				}
+				seen |= SEEN_JOBS;
 			} else {
 				return -1;
 			}
-		} else if (equal(*(argv + 2), "-n")) {
-			noise_file = *(argv + 3);
-			if (argc == 4) {
-				setG();
-				audio_samples = 8000; // Default MSEC 1000 time
-				return 0;
-			} else if (equal(*(argv + 4), "-t")){
-				int MSEC = parse(*(argv + 5));
-				if (MSEC <= UINT32_MAX && MSEC >= 0) { // MSEC <= UINT32_MAX && 2,147,483,647 / 8
-					audio_samples = MSEC * 8;
-					if (audio_samples < 0) {
+		}
+		setG();
+		return 0;
+	}
+	if (equal(first, "-d")) {
+		// printf("%s\n", "Got detect");
+		block_size = DEFAULT_BLOCK_SIZE;
+		hop_size = 0;
+		goertzel_engine = GOERTZEL_ENGINE_FLOAT;
+		stream_mode = 0;
+		pipeline_mode = 0;
+		coarse_size = 0;
+		tone_families = 0;
+		num_jobs = 1;
+		batch_mode = 0;
+		batch_files = NULL;
+		batch_count = 0;
+		sidecar_file = NULL;
+		redecide_file = NULL;
+		thresholds_spec = NULL;
+		sweep_spec = NULL;
+		int seen = 0; // bitmap of options already given
+		for (int i = 2; i < argc; i += 2) {
+			char *opt = *(argv + i);
+			// Anything that is not an option begins the list of input files.
+			if (*opt != '-') {
+				batch_files = argv + i;
+				batch_count = argc - i;
+				batch_mode |= DTMF_BATCH_FILES;
+				break;
+			}
+			// Options without arguments.
+			if (equal(opt, "-s") && !(seen & SEEN_STREAM)) {
+				stream_mode |= DTMF_TRACKER_STREAM;
+				seen |= SEEN_STREAM;
+				i--;
+				continue;
+			} else if (equal(opt, "-o") && !(seen & SEEN_ONSET)) {
+				stream_mode |= DTMF_TRACKER_ONSET;
+				seen |= SEEN_ONSET;
+				i--;
+				continue;
+			} else if (equal(opt, "-p") && !(seen & SEEN_PIPELINE)) {
+				pipeline_mode = 1;
+				seen |= SEEN_PIPELINE;
+				i--;
+				continue;
+			} else if (equal(opt, "-L") && !(seen & SEEN_LIST)) {
+				batch_mode |= DTMF_BATCH_LIST;
+				seen |= SEEN_LIST;
+				i--;
+				continue;
+			} else if (equal(opt, "-w") && !(seen & SEEN_WRITE)) {
+				batch_mode |= DTMF_BATCH_WRITE;
+				seen |= SEEN_WRITE;
+				i--;
+				continue;
+			}
+			if (i + 1 >= argc) {
+				return -1;
+			}
+			char *arg = *(argv + i + 1);
+			if (equal(opt, "-b") && !(seen & SEEN_BLOCK)) {
+				int count = parse(arg);
+				if (count < 10 || count > 1000) {
 					return -1;
-					}
-					if (argc == 6) {
-						setG();
-						return 0;
-					} else if (equal(*(argv + 6), "-l")) {
-						char * level = *(argv + 7);
-						int bool = 0; // is negative?
-						if (*level == 45) {
-							bool = 1;
-							level++;
-						}
-						int count = 0;
-						while (*level != 0) {
-							int num = *level - '0';
-							if (num < 0 || num > 9) {
-								return -1;
-							}
-							count += num;
-							level++;
-							if (*level == 0) {
-								break;
-							}
-							count = count * 10;
-						}
-						if (bool) {
-							count = 0 - count;
-						}
-						if (count >= -30 && count <= 30) {
-							noise_level = count;
-							setG();
-							return 0;
-						} else {
-							return -1;
-						}
-					} else {
-						return -1;
-					}
+				}
+				block_size = count;
+				seen |= SEEN_BLOCK;
+			} else if (equal(opt, "-e") && !(seen & SEEN_ENGINE)) {
+				if (equal(arg, "float")) {
+					goertzel_engine = GOERTZEL_ENGINE_FLOAT;
+				} else if (equal(arg, "fixed")) {
+					goertzel_engine = GOERTZEL_ENGINE_FIXED;
+				} else if (equal(arg, "fft")) {
+					goertzel_engine = GOERTZEL_ENGINE_FFT;
+				} else if (equal(arg, "auto")) {
+					goertzel_engine = GOERTZEL_ENGINE_AUTO;
 				} else {
 					return -1;
 				}
-			} else if (equal(*(argv + 4), "-l")){ // l and t
-				char * level = *(argv + 5);
-				int bool = 0; // is negative?
-				if (*level == 45) {
-					bool = 1;
-					level++;
-				}
-				int count = 0;
-				while (*level != 0) {
-					int num = *level - '0';
-					if (num < 0 || num > 9) {
-						return -1;
-					}
-					count += num;
-					level++;
-					if (*level == 0) {
-						break;
-					}
-					count = count * 10;
+				seen |= SEEN_ENGINE;
+			} else if (equal(opt, "-H") && !(seen & SEEN_HOP)) {
+				int count = parse(arg);
+				if (count < 1 || count > 1000) {
+					return -1;
 				}
-				if (bool) {
-					count = 0 - count;
+				hop_size = count;
+				seen |= SEEN_HOP;
+			} else if (equal(opt, "-j") && !(seen & SEEN_JOBS)) {
+				int count = parse(arg);
+				if (count < 1 || count > MAX_JOBS) {
+					return -1;
 				}
-				if (count >= -30 && count <= 30) {
-					noise_level = count;
-					if (argc == 6) {
-						setG();
-						audio_samples = 8000; // Default MSEC 1000 time
-						return 0;
-					} else if (equal(*(argv + 6), "-t")) {
-						int MSEC = parse(*(argv + 7));
-						if (MSEC <= UINT32_MAX && MSEC >= 0) { // MSEC <= UINT32_MAX && 2,147,483,647 / 8
-							audio_samples = MSEC * 8;
-							if (audio_samples < 0) {
-								return -1;
-							}
-							setG();
-							return 0;
-						} else {
-							return -1;
-						}
-					} else {
-						return -1;
-					}
-				} else {
+				num_jobs = count;
+				seen |= SEEN_JOBS;
+			} else if (equal(opt, "-c") && !(seen & SEEN_COARSE)) {
+				int count = parse(arg);
+				if (count < 10 || count > 1000) {
 					return -1;
 				}
-			} else {
-				return -1;
-			}
-		} else if (equal(*(argv + 2), "-l")) {
-			char * level = *(argv + 3);
-			int bool = 0; // is negative?
-			if (*level == 45) {
-				bool = 1;
-				level++;
-			}
-			int count = 0;
-			while (*level != 0) {
-				int num = *level - '0';
-				if (num < 0 || num > 9) {
+				coarse_size = count;
+				seen |= SEEN_COARSE;
+			} else if (equal(opt, "-T") && !(seen & SEEN_TONES)) {
+				if (parse_families(arg) == -1) {
 					return -1;
 				}
-				count += num;
-				level++;
-				if (*level == 0) {
-					break;
+				seen |= SEEN_TONES;
+			} else if (equal(opt, "-S") && !(seen & SEEN_SIDECAR)) {
+				sidecar_file = arg;
+				seen |= SEEN_SIDECAR;
+			} else if (equal(opt, "-r") && !(seen & SEEN_REDECIDE)) {
+				redecide_file = arg;
+				seen |= SEEN_REDECIDE;
+			} else if (equal(opt, "-x") && !(seen & SEEN_THRESHOLDS)) {
+				DTMF_THRESHOLDS thresholds;
+				if (dtmf_thresholds_parse(arg, &thresholds) == -1) {
+					return -1;
 				}
-				count = count * 10;
-			}
-			if (bool) {
-				count = 0 - count;
-			}
-			if (count >= -30 && count <= 30) {
-				noise_level = count;
-				if (argc == 4) {
-					setG();
-					audio_samples = 8000; // Default MSEC 1000 time
-					return 0;
-				} else if (equal(*(argv + 4), "-t")) {
-					int MSEC = parse(*(argv + 5));
-					if (MSEC <= UINT32_MAX && MSEC >= 0) { // MSEC <= UINT32_MAX && 2,147,483,647 / 8
-						audio_samples = MSEC * 8;
-						if (audio_samples < 0) {
-							return -1;
-						}
-						if (argc == 6) {
-							setG();
-							return 0;
-						} else if (equal(*(argv + 6), "-n")) {
-							noise_file = *(argv + 7);
-							setG();
-							return 0;
-						} else {
-							return -1;
-						}
-					} else {
-						return -1;
-					}
-				} else if (equal(*(argv + 4), "-n")) {
-					noise_file = *(argv + 5);
-					if (argc == 6) {
-						setG();
-						audio_samples = 8000; // Default MSEC 1000 time
-						return 0;
-					} else if (equal(*(argv + 6), "-t")) {
-						int MSEC = parse(*(argv + 7));
-						if (MSEC <= UINT32_MAX && MSEC >= 0) { // MSEC <= UINT32_MAX && 2,147,483,647 / 8
-							audio_samples = MSEC * 8;
-							if (audio_samples < 0) {
-							return -1;
-							}
-							setG();
-							return 0;
-						} else {
-							return -1;
-						}
-					} else {
-						return -1;
-					}
-				} else {
+				thresholds_spec = arg;
+				seen |= SEEN_THRESHOLDS;
+			} else if (equal(opt, "-B") && !(seen & SEEN_SWEEP)) {
+				if (dtmf_sweep_parse(arg, NULL, SWEEP_MAX_SIZES) == -1) {
 					return -1;
 				}
+				sweep_spec = arg;
+				seen |= SEEN_SWEEP;
 			} else {
 				return -1;
 			}
-		} else {
+		}
+		// Tone families are detected by detectors of their own, fed from one buffer, in order.
+		if (tone_families != 0 && ((hop_size != 0 && hop_size < block_size) || coarse_size
+		    || stream_mode || batch_mode || num_jobs > 1)) {
 			return -1;
 		}
-	}
-	if (equal(first, "-d")) {
-		// printf("%s\n", "Got detect");
-		if (argc > 4) {
+		// Coarse blocks are whole numbers of fine blocks, and two-pass detection needs all
+		// of the input at once, in one thread.
+		if (coarse_size != 0 && (coarse_size <= block_size || coarse_size % block_size != 0
+		    || (hop_size != 0 && hop_size < block_size) || stream_mode || batch_mode
+		    || num_jobs > 1)) {
 			return -1;
 		}
-		if (argc == 2) {
-			setD();
-			block_size = DEFAULT_BLOCK_SIZE;
-			return 0;
-		} else if (equal(*(argv + 2), "-b")) {
-			// char *blockSize = *(argv + 3);
-			int count = parse(*(argv + 3));
-			if (count >= 10 && count <= 1000) {
-				block_size = count;
-				setD();
-				return 0;
-			} else {
-				return -1;
-			}
-		} else {
+		// The hop may not exceed the window, and sliding windows use floating point only.
+		if (hop_size > block_size || (hop_size != 0 && goertzel_engine != GOERTZEL_ENGINE_FLOAT
+				&& goertzel_engine != GOERTZEL_ENGINE_AUTO)) {
 			return -1;
 		}
+		// Overlapping windows of one input are analyzed in order, in one thread.
+		if (hop_size != 0 && hop_size < block_size && num_jobs > 1 && !batch_mode) {
+			return -1;
+		}
+		// Onsets are only announced when streaming, and streams are not divided among jobs.
+		if (stream_mode == DTMF_TRACKER_ONSET || (stream_mode && num_jobs > 1)) {
+			return -1;
+		}
+		// The pipeline is for one stream, analyzed in order.
+		if (pipeline_mode && (coarse_size || tone_families || num_jobs > 1 || batch_mode)) {
+			return -1;
+		}
+		// A sidecar is written for one input, by one detector for the DTMF tones.
+		if (sidecar_file && (coarse_size || tone_families || num_jobs > 1 || batch_mode)) {
+			return -1;
+		}
+		// A sweep sets the block size itself, and is one pass over one input, in order.
+		if (sweep_spec && ((seen & (SEEN_BLOCK | SEEN_HOP | SEEN_COARSE | SEEN_TONES | SEEN_STREAM
+		    | SEEN_PIPELINE | SEEN_SIDECAR))
+		    || num_jobs > 1 || batch_mode)) {
+			return -1;
+		}
+		// Re-deciding reads nothing but the sidecar, whose windows are already fixed, and
+		// thresholds can only be given for that.
+		if ((redecide_file && ((seen & ~(SEEN_REDECIDE | SEEN_THRESHOLDS)) || batch_mode)) || (thresholds_spec && !redecide_file)) {
+			return -1;
+		}
+		// Input files come from the command line or from a list, and are not streamed.
+		if (((batch_mode & DTMF_BATCH_FILES) && (batch_mode & DTMF_BATCH_LIST))
+		    || batch_mode == DTMF_BATCH_WRITE || (batch_mode && stream_mode)) {
+			return -1;
+		}
+		setD();
+		return 0;
 	}
 	return -1;
 }
@@ -0,0 +1,137 @@
+#include <stdint.h>
+
+#include "const.h"
+#include "debug.h"
+#include "dtmf_analysis.h"
+#include "fft_real.h"
+#include "goertzel_bank.h"
+#include "goertzel_fixed.h"
+
+void dtmf_plans_init(GOERTZEL_PLAN *plans, int N) {
+	for (int F = 0; F < NUM_DTMF_FREQS; F++) {
+		double k = *(dtmf_freqs + F) * N * 1.0 / AUDIO_FRAME_RATE;
+		goertzel_plan_init(plans + F, N, k);
+	}
+}
+
+static void findStrong(const double *strengths, int* row_index, int* col_index,
+                       double* strong_row, double* strong_col) {
+	for (int i = 0; i < 4; i++) {
+		if (*(strengths + i) > *strong_row) {
+			*strong_row = *(strengths + i);
+			*row_index = i;
+		}
+		if (*(strengths + i + 4) > *strong_col) {
+			*strong_col = *(strengths + i + 4);
+			*col_index = i;
+		}
+	}
+}
+
+static int checkSixDB(const double *strengths, int row_index, int col_index, double margin) {
+	for (int i = 0; i < NUM_DTMF_ROW_FREQS; i++) {
+		if ((i != row_index) && (*(strengths + row_index) < *(strengths + i) * margin)) {
+			return 0;
+		}
+		if ((i != col_index) && (*(strengths + 4 + col_index) < *(strengths + i + 4) * margin)) {
+			return 0;
+		}
+	}
+	return 1;
+}
+
+/*
+ * The decision itself, inlined into each caller so that the default thresholds
+ * remain constants.
+ */
+static inline int classify(const double *strengths, double floor, double twist, double margin) {
+	double strong_row = 0;
+	double strong_col = 0;
+	int row_index = 0;
+	int col_index = 0;
+	findStrong(strengths, &row_index, &col_index, &strong_row, &strong_col);
+	if (strong_row + strong_col < floor) {
+		return 0;
+	}
+	double ratio = strong_row / strong_col;
+	if (ratio > twist || ratio < 1/twist) {
+		return 0;
+	}
+	if (!checkSixDB(strengths, row_index, col_index, margin)) {
+		return 0;
+	}
+	return *(*(dtmf_symbol_names + row_index) + col_index);
+}
+
+int dtmf_classify_strengths(const double *strengths) {
+	return classify(strengths, MINUS_20DB, FOUR_DB, SIX_DB);
+}
+
+const DTMF_THRESHOLDS dtmf_default_thresholds = {
+	.twist = FOUR_DB, .margin = SIX_DB, .floor = MINUS_20DB, .min_duration = MIN_DTMF_DURATION
+};
+
+int dtmf_classify_thresholds(const double *strengths, const DTMF_THRESHOLDS *tp) {
+	return classify(strengths, tp -> floor, tp -> twist, tp -> margin);
+}
+
+int64_t dtmf_block_energy(const int16_t *samples, int N) {
+	int64_t energy = 0;
+	for (int i = 0; i < N; i++) {
+		energy += (int32_t)*(samples + i) * *(samples + i);
+	}
+	return energy;
+}
+
+int dtmf_energy_quiet(int64_t energy, int N) {
+	return 4.0 * energy < DTMF_GATE_MARGIN * MINUS_20DB * N * ((double)INT16_MAX * INT16_MAX);
+}
+
+int dtmf_block_quiet(const int16_t *samples, int N) {
+	return dtmf_energy_quiet(dtmf_block_energy(samples, N), N);
+}
+
+int dtmf_analyze_block(const GOERTZEL_PLAN *plans, int engine, const int16_t *samples,
+                       double *strengths) {
+	int N = plans -> N;
+	if (engine == GOERTZEL_ENGINE_FFT) {
+		fft_strengths(plans, NUM_DTMF_FREQS, samples, strengths);
+		return dtmf_classify_strengths(strengths);
+	}
+	GOERTZEL_STATE states[NUM_DTMF_FREQS];
+	for (int F = 0; F < NUM_DTMF_FREQS; F++) {
+		goertzel_plan_start(plans + F, states + F);
+	}
+	if (engine == GOERTZEL_ENGINE_FIXED) {
+		GOERTZEL_QBANK qbank;
+		goertzel_qbank_load(&qbank, states);
+		goertzel_qbank_run(&qbank, samples, N - 1);
+		goertzel_qbank_store(&qbank, states);
+	} else {
+		GOERTZEL_BANK bank;
+		goertzel_bank_load(&bank, states);
+		goertzel_bank_run(&bank, samples, N - 1);
+		goertzel_bank_store(&bank, states);
+	}
+	double x = (double)*(samples + N - 1) / INT16_MAX;
+	for (int F = 0; F < NUM_DTMF_FREQS; F++) {
+		*(strengths + F) = goertzel_plan_strength(plans + F, states + F, x);
+	}
+	return dtmf_classify_strengths(strengths);
+}
+
+int dtmf_engine_select(int engine, int bins, int N) {
+	if (engine != GOERTZEL_ENGINE_AUTO) {
+		return engine;
+	}
+	int M = fft_size(N);
+	int log2M = 0;
+	while ((1 << log2M) < M) {
+		log2M++;
+	}
+	double goertzel_cost = (double)bins * N;
+	double fft_cost = FFT_TERMS * (DTMF_FFT_COST * (M / 4) * (log2M - 1) + M + bins);
+	int choice = fft_cost < goertzel_cost ? GOERTZEL_ENGINE_FFT : GOERTZEL_ENGINE_FLOAT;
+	debug("engine: %d bins, N = %d: %s", bins, N, choice == GOERTZEL_ENGINE_FFT ? "fft" : "float");
+	return choice;
+}
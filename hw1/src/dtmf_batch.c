@@ -0,0 +1,292 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#include "audio_io.h"
+#include "const.h"
+#include "debug.h"
+#include "dtmf_batch.h"
+#include "dtmf_channels.h"
+
+/*
+ * Output of one file, held until the output of all files named before it has
+ * been written.
+ */
+typedef struct batch_result {
+    char *buf;
+    size_t size;
+    int done;
+} BATCH_RESULT;
+
+/*
+ * State shared by the worker threads.
+ */
+typedef struct batch {
+    char **files;
+    int count;
+    const DTMF_DETECTOR_CONFIG *cfg;
+    int flags;
+    FILE *events_out;
+    pthread_mutex_t lock;       // Protects the following fields.
+    int next;                   // Index of the next file to be claimed.
+    int written;                // Index of the next file whose output is to be written.
+    BATCH_RESULT *results;
+    int failed;
+} BATCH;
+
+/*
+ * Argument of print_prefixed.
+ */
+typedef struct prefix_arg {
+    FILE *out;
+    const char *name;
+} PREFIX_ARG;
+
+static void print_prefixed(void *arg, int start, int end, uint8_t symbol) {
+    PREFIX_ARG *pa = arg;
+    fprintf(pa -> out, "%s\t", pa -> name);
+    dtmf_event_print(pa -> out, start, end, symbol);
+}
+
+static void print_channel_prefixed(void *arg, int channel, int start, int end, uint8_t symbol) {
+    PREFIX_ARG *pa = arg;
+    fprintf(pa -> out, "%s\t", pa -> name);
+    dtmf_channel_event_print(pa -> out, channel, start, end, symbol);
+}
+
+/*
+ * Open an audio file and read its header.
+ *
+ *   @return  The file, positioned at the sample data, or NULL if it could not be
+ *   opened or its header is not valid.
+ */
+static FILE *open_audio(const char *name, AUDIO_HEADER *hp) {
+    FILE *in = fopen(name, "r");
+    if (in != NULL && audio_read_header(in, hp) == EOF) {
+        fclose(in);
+        in = NULL;
+    }
+    return in;
+}
+
+/*
+ * Detect DTMF events in an audio file opened by open_audio, reporting them to func,
+ * or to channel_func if the file has more than one channel, and close it.
+ *
+ *   @return  0 if successful, EOF if the file could not be analyzed.
+ */
+static int detect_file(FILE *in, const AUDIO_HEADER *hp, const DTMF_DETECTOR_CONFIG *cfg,
+                       DTMF_EVENT_FUNC *func, DTMF_CHANNEL_EVENT_FUNC *channel_func, void *arg) {
+    DTMF_DETECTOR *dp = NULL;
+    DTMF_DETECTOR_CONFIG fc = *cfg;
+    fc.encoding = hp -> encoding;
+    fc.sample_rate = hp -> sample_rate;
+    if (hp -> channels > AUDIO_CHANNELS) {
+        int ret = dtmf_detect_channels(in, &fc, hp -> channels, channel_func, arg);
+        fclose(in);
+        return ret;
+    }
+    if ((dp = dtmf_detector_new(&fc)) == NULL) {
+        fclose(in);
+        return EOF;
+    }
+    int16_t samples[SAMPLE_BUF_SIZE];
+    size_t got;
+    while ((got = audio_read_encoded(in, hp -> encoding, samples, SAMPLE_BUF_SIZE)) > 0) {
+        dtmf_detector_feed(dp, samples, got, func, arg);
+    }
+    dtmf_detector_finish(dp, func, arg);
+    dtmf_detector_free(dp);
+    fclose(in);
+    return 0;
+}
+
+/*
+ * Name of the file to which the events for an audio file are written:
+ * the same name, with the suffix ".au" replaced by ".txt".
+ */
+static char *events_name(const char *name) {
+    size_t n = 0;
+    while (*(name + n) != '\0') {
+        n++;
+    }
+    if (n >= 3 && *(name + n - 3) == '.' && *(name + n - 2) == 'a' && *(name + n - 1) == 'u') {
+        n -= 3;
+    }
+    char *out = malloc(n + 5);
+    if (out == NULL) {
+        return NULL;
+    }
+    for (size_t i = 0; i < n; i++) {
+        *(out + i) = *(name + i);
+    }
+    char *suffix = ".txt";
+    for (size_t i = 0; i < 5; i++) {
+        *(out + n + i) = *(suffix + i);
+    }
+    return out;
+}
+
+/*
+ * Process one file of a batch, leaving its output, if it is to go to the shared
+ * stream, in its result.
+ */
+static int batch_file(BATCH *bp, int i) {
+    char *name = *(bp -> files + i);
+    BATCH_RESULT *rp = bp -> results + i;
+    AUDIO_HEADER hd;
+    FILE *in = open_audio(name, &hd);
+    if (in == NULL) {
+        return EOF;
+    }
+    if (bp -> flags & DTMF_BATCH_WRITE) {
+        // The events file is only created for audio that can be read, and is removed
+        // if it cannot be analyzed after all, so that it is never taken for "no tones".
+        char *out_name = events_name(name);
+        FILE *out = out_name != NULL ? fopen(out_name, "w") : NULL;
+        if (out == NULL) {
+            free(out_name);
+            fclose(in);
+            return EOF;
+        }
+        int ret = detect_file(in, &hd, bp -> cfg, dtmf_event_print, dtmf_channel_event_print, out);
+        if (fclose(out) == EOF) {
+            ret = EOF;
+        }
+        if (ret == EOF) {
+            unlink(out_name);
+        }
+        free(out_name);
+        return ret;
+    }
+    FILE *out = open_memstream(&rp -> buf, &rp -> size);
+    if (out == NULL) {
+        fclose(in);
+        return EOF;
+    }
+    PREFIX_ARG pa = { .out = out, .name = name };
+    int ret = detect_file(in, &hd, bp -> cfg, print_prefixed, print_channel_prefixed, &pa);
+    fclose(out);
+    return ret;
+}
+
+static void *batch_worker(void *arg) {
+    BATCH *bp = arg;
+    while (1) {
+        pthread_mutex_lock(&bp -> lock);
+        int i = bp -> next++;
+        pthread_mutex_unlock(&bp -> lock);
+        if (i >= bp -> count) {
+            return NULL;
+        }
+        int ret = batch_file(bp, i);
+        pthread_mutex_lock(&bp -> lock);
+        if (ret == EOF) {
+            fprintf(stderr, "%s: cannot detect DTMF events\n", *(bp -> files + i));
+            bp -> failed = 1;
+        }
+        (bp -> results + i) -> done = 1;
+        // Write out, in order, all the output that no longer waits on an earlier file.
+        while (bp -> written < bp -> count && (bp -> results + bp -> written) -> done) {
+            BATCH_RESULT *rp = bp -> results + bp -> written;
+            if (rp -> buf != NULL) {
+                fwrite(rp -> buf, 1, rp -> size, bp -> events_out);
+                free(rp -> buf);
+                rp -> buf = NULL;
+            }
+            bp -> written++;
+        }
+        pthread_mutex_unlock(&bp -> lock);
+    }
+}
+
+/*
+ * Read file names, one per line, ignoring empty lines.
+ *
+ *   @return  The number of names read, or -1 if there was not enough memory.
+ */
+static int read_list(FILE *list_in, char ***filesp) {
+    char **files = NULL;
+    int count = 0;
+    int cap = 0;
+    char *line = NULL;
+    size_t size = 0;
+    ssize_t n;
+    while ((n = getline(&line, &size, list_in)) != -1) {
+        while (n > 0 && (*(line + n - 1) == '\n' || *(line + n - 1) == '\r')) {
+            *(line + --n) = '\0';
+        }
+        if (n == 0) {
+            continue;
+        }
+        if (count == cap) {
+            cap = cap ? 2 * cap : 64;
+            char **more = realloc(files, cap * sizeof(char *));
+            if (more == NULL) {
+                for (int i = 0; i < count; i++) {
+                    free(*(files + i));
+                }
+                free(files);
+                free(line);
+                *filesp = NULL;
+                return -1;
+            }
+            files = more;
+        }
+        *(files + count++) = line;
+        line = NULL;
+        size = 0;
+    }
+    free(line);
+    *filesp = files;
+    return count;
+}
+
+int dtmf_detect_batch(char **files, int count, FILE *list_in, const DTMF_DETECTOR_CONFIG *cfg,
+                      int jobs, int flags, FILE *events_out) {
+    char **list = NULL;
+    if (files == NULL) {
+        count = read_list(list_in, &list);
+        files = list;
+    }
+    BATCH batch = {
+        .files = files, .count = count, .cfg = cfg, .flags = flags, .events_out = events_out,
+        .next = 0, .written = 0, .failed = 0
+    };
+    batch.results = count > 0 ? calloc(count, sizeof(BATCH_RESULT)) : NULL;
+    int ret = count < 0 || (count > 0 && batch.results == NULL) ? EOF : 0;
+    if (ret == 0 && count > 0) {
+        pthread_mutex_init(&batch.lock, NULL);
+        if (jobs > count) {
+            jobs = count;
+        }
+        pthread_t threads[jobs];
+        int started = 0;
+        for (int j = 0; j < jobs; j++) {
+            if (pthread_create(threads + j, NULL, batch_worker, &batch) == 0) {
+                started++;
+            }
+        }
+        if (started == 0) {
+            batch_worker(&batch);
+        }
+        for (int j = 0; j < started; j++) {
+            pthread_join(*(threads + j), NULL);
+        }
+        pthread_mutex_destroy(&batch.lock);
+        if (batch.failed) {
+            ret = EOF;
+        }
+    }
+    free(batch.results);
+    if (list != NULL) {
+        for (int i = 0; i < count; i++) {
+            free(*(list + i));
+        }
+        free(list);
+    }
+    fflush(events_out);
+    return ret;
+}
@@ -0,0 +1,75 @@
+#include <stdio.h>
+#include <stdint.h>
+
+#include "audio_io.h"
+#include "const.h"
+#include "debug.h"
+#include "dtmf_channels.h"
+
+/*
+ * Where the events of one channel go.
+ */
+typedef struct channel_output {
+    int channel;
+    DTMF_CHANNEL_EVENT_FUNC *func;
+    void *arg;
+} CHANNEL_OUTPUT;
+
+static void report_channel_event(void *arg, int start, int end, uint8_t symbol) {
+    CHANNEL_OUTPUT *op = arg;
+    op -> func(op -> arg, op -> channel, start, end, symbol);
+}
+
+void dtmf_channel_event_print(void *arg, int channel, int start, int end, uint8_t symbol) {
+    fprintf(arg, "%d\t", channel);
+    dtmf_event_print(arg, start, end, symbol);
+}
+
+int dtmf_detect_channels(FILE *audio_in, const DTMF_DETECTOR_CONFIG *cfg, int channels,
+                         DTMF_CHANNEL_EVENT_FUNC *func, void *arg) {
+    if (channels < 1 || channels > AUDIO_MAX_CHANNELS) {
+        return EOF;
+    }
+    DTMF_DETECTOR *detectors[AUDIO_MAX_CHANNELS];
+    CHANNEL_OUTPUT outputs[AUDIO_MAX_CHANNELS];
+    int count = 0;
+    int ret = 0;
+    for (; count < channels; count++) {
+        if ((*(detectors + count) = dtmf_detector_new(cfg)) == NULL) {
+            ret = EOF;
+            break;
+        }
+        *(outputs + count) = (CHANNEL_OUTPUT){ .channel = count, .func = func, .arg = arg };
+    }
+    if (ret == 0) {
+        // Frames are read into frames, and separated into one run per channel in runs.
+        int per_buf = SAMPLE_BUF_SIZE / channels;
+        int16_t frames[SAMPLE_BUF_SIZE];
+        int16_t runs[SAMPLE_BUF_SIZE];
+        size_t have = 0;  // Samples of a partial frame left over from the previous read.
+        size_t got;
+        while ((got = audio_read_encoded(audio_in, cfg -> encoding, frames + have,
+                                         per_buf * channels - have)) > 0) {
+            have += got;
+            size_t n = have / channels;
+            for (int c = 0; c < channels; c++) {
+                int16_t *run = runs + c * per_buf;
+                for (size_t i = 0; i < n; i++) {
+                    *(run + i) = *(frames + i * channels + c);
+                }
+                dtmf_detector_feed(*(detectors + c), run, n, report_channel_event, outputs + c);
+            }
+            for (size_t i = n * channels; i < have; i++) {
+                *(frames + i - n * channels) = *(frames + i);
+            }
+            have -= n * channels;
+        }
+        for (int c = 0; c < channels; c++) {
+            dtmf_detector_finish(*(detectors + c), report_channel_event, outputs + c);
+        }
+    }
+    for (int c = 0; c < count; c++) {
+        dtmf_detector_free(*(detectors + c));
+    }
+    return ret;
+}
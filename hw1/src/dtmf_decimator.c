@@ -0,0 +1,198 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "audio.h"
+#include "audio_io.h"
+#include "debug.h"
+#include "dtmf_decimator.h"
+
+struct dtmf_decimator {
+    int up;           // AUDIO_FRAME_RATE / rate = up / down, in lowest terms.
+    int down;
+    int taps;         // Coefficients in each phase of the filter.
+    int center;       // Index of the center of the prototype filter.
+    double *coeffs;   // up phases of taps coefficients, each in input order.
+    double *history;  // Input samples still needed, the first at index base.
+    size_t capacity;
+    size_t count;
+    int64_t base;
+    int64_t next;     // Index of the next output sample.
+    int64_t end;      // Number of input samples once finished, otherwise -1.
+};
+
+static uint32_t gcd(uint32_t a, uint32_t b) {
+    while (b != 0) {
+        uint32_t t = a % b;
+        a = b;
+        b = t;
+    }
+    return a;
+}
+
+/*
+ * Design the prototype filter, at up times the input rate, and split it into
+ * phases.  Phase p holds coefficients p + i * up of the prototype, for i from
+ * 0, which apply to input samples last - i, stored in reverse so that they line
+ * up with the history.
+ * Each phase is normalized to unit gain at DC, so that a constant input gives
+ * a constant output.
+ */
+static void design(DTMF_DECIMATOR *dp, uint32_t rate) {
+    int length = dp -> up * dp -> taps;
+    double fc = (double)AUDIO_FRAME_RATE / 2 / ((double)dp -> up * rate);
+    for (int p = 0; p < dp -> up; p++) {
+        double *phase = dp -> coeffs + p * dp -> taps;
+        double sum = 0;
+        for (int i = 0; i < dp -> taps; i++) {
+            double x = p + i * dp -> up - dp -> center;
+            double sinc = x == 0 ? 2 * fc : sin(2 * M_PI * fc * x) / (M_PI * x);
+            double w = 0.42 + 0.5 * cos(2 * M_PI * x / length) + 0.08 * cos(4 * M_PI * x / length);
+            *(phase + dp -> taps - 1 - i) = sinc * w;
+            sum += sinc * w;
+        }
+        for (int i = 0; i < dp -> taps; i++) {
+            *(phase + i) /= sum;
+        }
+    }
+}
+
+int dtmf_decimator_supported(uint32_t rate) {
+    return rate >= AUDIO_FRAME_RATE && rate <= AUDIO_MAX_RATE
+        && AUDIO_FRAME_RATE / gcd(AUDIO_FRAME_RATE, rate) <= DECIMATOR_MAX_UP;
+}
+
+DTMF_DECIMATOR *dtmf_decimator_new(uint32_t rate) {
+    if (!dtmf_decimator_supported(rate)) {
+        return NULL;
+    }
+    uint32_t g = gcd(AUDIO_FRAME_RATE, rate);
+    DTMF_DECIMATOR *dp = calloc(1, sizeof(DTMF_DECIMATOR));
+    if (dp == NULL) {
+        return NULL;
+    }
+    dp -> up = AUDIO_FRAME_RATE / g;
+    dp -> down = rate / g;
+    // Blackman-windowed filters need about 5.5 input samples per transition width;
+    // a multiple of 4 taps lets the inner loop keep four sums.
+    dp -> taps = ((int)ceil(5.5 * rate / DECIMATOR_TRANSITION) + 3) & ~3;
+    dp -> center = (dp -> up * dp -> taps - 1) / 2;
+    // Room for a chunk of input on top of a window, and for the silence after the end.
+    dp -> capacity = 2 * dp -> taps + DECIMATOR_CHUNK;
+    dp -> coeffs = malloc(dp -> up * dp -> taps * sizeof(double));
+    dp -> history = malloc(dp -> capacity * sizeof(double));
+    if (dp -> coeffs == NULL || dp -> history == NULL) {
+        dtmf_decimator_free(dp);
+        return NULL;
+    }
+    design(dp, rate);
+    dtmf_decimator_reset(dp);
+    return dp;
+}
+
+void dtmf_decimator_reset(DTMF_DECIMATOR *dp) {
+    // The history starts with a window of silence before the first input sample.
+    for (int i = 0; i < dp -> taps; i++) {
+        *(dp -> history + i) = 0;
+    }
+    dp -> count = dp -> taps;
+    dp -> base = -dp -> taps;
+    dp -> next = 0;
+    dp -> end = -1;
+}
+
+void dtmf_decimator_free(DTMF_DECIMATOR *dp) {
+    if (dp == NULL) {
+        return;
+    }
+    free(dp -> coeffs);
+    free(dp -> history);
+    free(dp);
+}
+
+int dtmf_decimator_input_index(const DTMF_DECIMATOR *dp, int index) {
+    return ((int64_t)index * dp -> down + dp -> up / 2) / dp -> up;
+}
+
+/*
+ * Compute output samples while the input that they need is in the history, up to
+ * the end of the input, if known, and at most max of them.
+ */
+static size_t produce(DTMF_DECIMATOR *dp, int16_t *out, size_t max) {
+    size_t produced = 0;
+    while (produced < max && (dp -> end < 0 || dp -> next * dp -> down < dp -> end * dp -> up)) {
+        int64_t u = dp -> next * dp -> down + dp -> center;
+        int64_t last = u / dp -> up;
+        if (last >= dp -> base + (int64_t)dp -> count) {
+            break;
+        }
+        const double *h = dp -> coeffs + (u - last * dp -> up) * dp -> taps;
+        const double *x = dp -> history + (last - dp -> taps + 1 - dp -> base);
+        double s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+        for (int i = 0; i < dp -> taps; i += 4) {
+            s0 += *(h + i) * *(x + i);
+            s1 += *(h + i + 1) * *(x + i + 1);
+            s2 += *(h + i + 2) * *(x + i + 2);
+            s3 += *(h + i + 3) * *(x + i + 3);
+        }
+        long y = lround((s0 + s1) + (s2 + s3));
+        *(out + produced++) = y > INT16_MAX ? INT16_MAX : y < INT16_MIN ? INT16_MIN : y;
+        dp -> next++;
+    }
+    return produced;
+}
+
+/*
+ * Discard the samples at the start of the history that no later output sample
+ * needs.  Since each phase spans more input samples than lie between two output
+ * samples, that never includes any sample not yet received.
+ */
+static void compact(DTMF_DECIMATOR *dp) {
+    int64_t first = (dp -> next * dp -> down + dp -> center) / dp -> up - dp -> taps + 1;
+    size_t drop = first - dp -> base;
+    if (first <= dp -> base) {
+        return;
+    }
+    if (drop > dp -> count) {
+        drop = dp -> count;
+    }
+    for (size_t i = drop; i < dp -> count; i++) {
+        *(dp -> history + i - drop) = *(dp -> history + i);
+    }
+    dp -> count -= drop;
+    dp -> base += drop;
+}
+
+size_t dtmf_decimator_run(DTMF_DECIMATOR *dp, const int16_t *in, size_t *np, int16_t *out,
+                          size_t max) {
+    size_t used = 0;
+    size_t produced = produce(dp, out, max);
+    while (produced < max && used < *np) {
+        compact(dp);
+        size_t take = dp -> capacity - dp -> taps - dp -> count;
+        if (take > *np - used) {
+            take = *np - used;
+        }
+        for (size_t i = 0; i < take; i++) {
+            *(dp -> history + dp -> count + i) = *(in + used + i);
+        }
+        dp -> count += take;
+        used += take;
+        produced += produce(dp, out + produced, max - produced);
+    }
+    *np = used;
+    return produced;
+}
+
+size_t dtmf_decimator_finish(DTMF_DECIMATOR *dp, int16_t *out, size_t max) {
+    if (dp -> end < 0) {
+        dp -> end = dp -> base + dp -> count;
+        compact(dp);
+        // Silence after the end, for the filters centered near it to reach into.
+        for (int i = 0; i < dp -> taps; i++) {
+            *(dp -> history + dp -> count++) = 0;
+        }
+    }
+    return produce(dp, out, max);
+}
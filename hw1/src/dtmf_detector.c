@@ -0,0 +1,302 @@
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "const.h"
+#include "debug.h"
+#include "dtmf_analysis.h"
+#include "dtmf_decimator.h"
+#include "dtmf_detector.h"
+#include "fft_real.h"
+#include "goertzel_bank.h"
+#include "goertzel_fixed.h"
+#include "goertzel_plan.h"
+#include "goertzel_sliding.h"
+
+struct dtmf_detector {
+    GOERTZEL_BANK bank;                       // Filter banks for the current block,
+    GOERTZEL_QBANK qbank;                     // with the engine selected by engine.
+    GOERTZEL_PLAN plans[NUM_DTMF_FREQS];      // Plans for the DTMF frequencies at block_size.
+    GOERTZEL_STATE states[NUM_DTMF_FREQS];
+    double strengths[NUM_DTMF_FREQS];
+    int block_size;
+    int hop_size;    // Hop between windows, if less than block_size, otherwise 0.
+    int engine;
+    int flags;       // Streaming mode flags for the tracker.
+    const TONE_FAMILY *family;  // Family of tones to detect, or NULL for DTMF.
+    DTMF_SIDECAR *sidecar;      // Where the strengths of each window go, or NULL.
+    int pos;         // Number of samples of the current block consumed so far.
+    int index;       // Index of the first sample of the current block.
+    DTMF_TRACKER tracker;
+    uint32_t rate;   // Sample rate of the input.
+    DTMF_DECIMATOR *decimator;  // For input at another rate than AUDIO_FRAME_RATE, or NULL.
+    int16_t decimated[DECIMATOR_CHUNK];      // Output of the decimator, for the filters.
+    int16_t block[GOERTZEL_SLIDING_MAX_N];   // Samples of the current block, for the FFT.
+    GOERTZEL_SLIDING *sliding;                // Sliding bank if hop_size is nonzero, or NULL.
+};
+
+DTMF_DETECTOR *dtmf_detector_new(const DTMF_DETECTOR_CONFIG *cfg) {
+    int N = cfg -> block_size;
+    int hop = cfg -> hop_size;
+    if (N < 10 || N > GOERTZEL_SLIDING_MAX_N || hop < 0 || hop > N) {
+        return NULL;
+    }
+    if (hop == N) {
+        hop = 0;
+    }
+    int engine = cfg -> engine;
+    if (hop != 0 && engine == GOERTZEL_ENGINE_AUTO) {
+        engine = GOERTZEL_ENGINE_FLOAT;
+    }
+    if ((hop != 0 && engine != GOERTZEL_ENGINE_FLOAT)
+        || (cfg -> sidecar != NULL && cfg -> family != NULL)) {
+        return NULL;
+    }
+    DTMF_DECIMATOR *decimator = NULL;
+    if (cfg -> sample_rate != 0 && cfg -> sample_rate != AUDIO_FRAME_RATE
+        && (decimator = dtmf_decimator_new(cfg -> sample_rate)) == NULL) {
+        return NULL;
+    }
+    engine = dtmf_engine_select(engine, cfg -> family != NULL ? cfg -> family -> nfreqs
+                                                             : NUM_DTMF_FREQS, N);
+    // The filter banks are aligned for vector loads, which malloc does not guarantee.
+    // The sliding bank, which is large, is allocated separately, only if it is needed.
+    DTMF_DETECTOR *dp;
+    GOERTZEL_SLIDING *sliding = NULL;
+    if (hop != 0 && posix_memalign((void **)&sliding, 32, sizeof(GOERTZEL_SLIDING)) != 0) {
+        dtmf_decimator_free(decimator);
+        return NULL;
+    }
+    if (posix_memalign((void **)&dp, 32, sizeof(DTMF_DETECTOR)) != 0) {
+        free(sliding);
+        dtmf_decimator_free(decimator);
+        return NULL;
+    }
+    dp -> sliding = sliding;
+    dp -> rate = decimator != NULL ? cfg -> sample_rate : AUDIO_FRAME_RATE;
+    dp -> decimator = decimator;
+    dp -> block_size = N;
+    dp -> hop_size = hop;
+    dp -> engine = engine;
+    dp -> flags = cfg -> flags;
+    dp -> family = cfg -> family;
+    dp -> sidecar = cfg -> sidecar;
+    if (dp -> family != NULL) {
+        tone_plans_init(dp -> plans, dp -> family, N);
+    } else {
+        dtmf_plans_init(dp -> plans, N);
+    }
+    dtmf_detector_reset(dp);
+    return dp;
+}
+
+void dtmf_detector_reset(DTMF_DETECTOR *dp) {
+    dp -> pos = 0;
+    dp -> index = 0;
+    if (dp -> decimator != NULL) {
+        dtmf_decimator_reset(dp -> decimator);
+    }
+    if (dp -> hop_size != 0) {
+        goertzel_sliding_init(dp -> sliding, dp -> plans);
+    }
+    dtmf_tracker_init(&dp -> tracker, dp -> block_size);
+    dp -> tracker.rate = dp -> rate;
+    if (dp -> hop_size != 0) {
+        dp -> tracker.hop = dp -> hop_size;
+    }
+    if (dp -> flags) {
+        dtmf_tracker_stream(&dp -> tracker, dp -> flags);
+    }
+}
+
+void dtmf_detector_free(DTMF_DETECTOR *dp) {
+    if (dp != NULL) {
+        dtmf_decimator_free(dp -> decimator);
+        free(dp -> sliding);
+    }
+    free(dp);
+}
+
+/*
+ * Start the analysis of a block.
+ */
+static void block_start(DTMF_DETECTOR *dp) {
+    if (dp -> engine == GOERTZEL_ENGINE_FFT) {
+        return;
+    }
+    for (int F = 0; F < NUM_DTMF_FREQS; F++) {
+        goertzel_plan_start(dp -> plans + F, dp -> states + F);
+    }
+    if (dp -> engine == GOERTZEL_ENGINE_FIXED) {
+        goertzel_qbank_load(&dp -> qbank, dp -> states);
+    } else {
+        goertzel_bank_load(&dp -> bank, dp -> states);
+    }
+}
+
+/*
+ * Run all the filters together over n samples of the current block,
+ * which must not include the last sample of the block.
+ */
+static void block_run(DTMF_DETECTOR *dp, const int16_t *samples, size_t n) {
+    if (dp -> engine == GOERTZEL_ENGINE_FFT) {
+        int16_t *block = dp -> block + dp -> pos;
+        for (size_t i = 0; i < n; i++) {
+            *(block + i) = *(samples + i);
+        }
+    } else if (dp -> engine == GOERTZEL_ENGINE_FIXED) {
+        goertzel_qbank_run(&dp -> qbank, samples, n);
+    } else {
+        goertzel_bank_run(&dp -> bank, samples, n);
+    }
+}
+
+/*
+ * Finish the analysis of the current block with its last sample,
+ * leaving the strengths in dp -> strengths.
+ */
+static void block_finish(DTMF_DETECTOR *dp, int16_t sample) {
+    if (dp -> engine == GOERTZEL_ENGINE_FFT) {
+        *(dp -> block + dp -> block_size - 1) = sample;
+        fft_strengths(dp -> plans, NUM_DTMF_FREQS, dp -> block, dp -> strengths);
+        return;
+    }
+    if (dp -> engine == GOERTZEL_ENGINE_FIXED) {
+        goertzel_qbank_store(&dp -> qbank, dp -> states);
+    } else {
+        goertzel_bank_store(&dp -> bank, dp -> states);
+    }
+    for (int F = 0; F < NUM_DTMF_FREQS; F++) {
+        *(dp -> strengths + F) = goertzel_plan_strength(dp -> plans + F, dp -> states + F,
+                                                        (double)sample / INT16_MAX);
+    }
+}
+
+/*
+ * Decide which tone, if any, is present in the current window, from dp -> strengths.
+ */
+static int window_classify(DTMF_DETECTOR *dp) {
+    if (dp -> sidecar != NULL) {
+        dtmf_sidecar_write(dp -> sidecar, dp -> strengths);
+    }
+    if (dp -> family != NULL) {
+        return tone_family_classify(dp -> family, dp -> strengths);
+    }
+    return dtmf_classify_strengths(dp -> strengths);
+}
+
+/*
+ * Sliding-window detection: analyze a window of block_size samples starting at
+ * every multiple of hop_size, maintaining the transforms with a sliding DFT so that
+ * each hop costs O(hop_size) rather than O(block_size).  Here the "block" is the
+ * next window to be completed, and pos counts the samples of it that have
+ * arrived, including those it shares with earlier windows.
+ */
+static void feed_sliding(DTMF_DETECTOR *dp, const int16_t *p, size_t n,
+                         DTMF_EVENT_FUNC *func, void *arg) {
+    while (n > 0) {
+        size_t step = (size_t)(dp -> block_size - dp -> pos) < n ? (size_t)(dp -> block_size - dp -> pos) : n;
+        goertzel_sliding_run(dp -> sliding, p, step);
+        p += step;
+        n -= step;
+        dp -> pos += step;
+        if (dp -> pos == dp -> block_size) {
+            goertzel_sliding_strengths(dp -> sliding, dp -> strengths);
+            uint8_t symbol = window_classify(dp);
+            const TONE_FAMILY *fp = dp -> family != NULL ? dp -> family
+                                                         : tone_family_get(TONE_FAMILY_DTMF);
+            dtmf_tracker_slide(&dp -> tracker, dp -> index, symbol,
+                               tone_family_power(fp, dp -> strengths, symbol), func, arg);
+            dp -> index += dp -> hop_size;
+            dp -> pos -= dp -> hop_size;
+        }
+    }
+}
+
+/*
+ * Feed samples at AUDIO_FRAME_RATE to the filters.  In block mode the filters run
+ * over each piece as it arrives, so that the decision for a block can be made as
+ * soon as its last sample is in.
+ */
+static void feed_rate(DTMF_DETECTOR *dp, const int16_t *p, size_t n,
+                        DTMF_EVENT_FUNC *func, void *arg) {
+    if (dp -> hop_size != 0) {
+        feed_sliding(dp, p, n, func, arg);
+        return;
+    }
+    int N = dp -> block_size;
+    while (n > 0) {
+        // A block that arrives whole can be passed through the energy gate first,
+        // unless its strengths are wanted whatever they are.
+        if (dp -> pos == 0 && n >= (size_t)N && dp -> sidecar == NULL && dtmf_block_quiet(p, N)) {
+            dtmf_tracker_window(&dp -> tracker, dp -> index, 0, func, arg);
+            p += N;
+            n -= N;
+            dp -> index += N;
+            continue;
+        }
+        if (dp -> pos == 0) {
+            block_start(dp);
+        }
+        if (dp -> pos < N - 1) {
+            size_t step = (size_t)(N - 1 - dp -> pos) < n ? (size_t)(N - 1 - dp -> pos) : n;
+            block_run(dp, p, step);
+            p += step;
+            n -= step;
+            dp -> pos += step;
+            continue;
+        }
+        block_finish(dp, *p);
+        p++;
+        n--;
+        dtmf_tracker_window(&dp -> tracker, dp -> index,
+                            window_classify(dp), func, arg);
+        dp -> index += N;
+        dp -> pos = 0;
+    }
+}
+
+/*
+ * Where the events of a detector with a decimator go, with their indices
+ * converted back to those of the input.
+ */
+typedef struct rate_output {
+    const DTMF_DECIMATOR *decimator;
+    DTMF_EVENT_FUNC *func;
+    void *arg;
+} RATE_OUTPUT;
+
+static void report_input_event(void *arg, int start, int end, uint8_t symbol) {
+    RATE_OUTPUT *op = arg;
+    op -> func(op -> arg, dtmf_decimator_input_index(op -> decimator, start),
+               end == -1 ? -1 : dtmf_decimator_input_index(op -> decimator, end), symbol);
+}
+
+void dtmf_detector_feed(DTMF_DETECTOR *dp, const int16_t *p, size_t n,
+                        DTMF_EVENT_FUNC *func, void *arg) {
+    if (dp -> decimator == NULL) {
+        feed_rate(dp, p, n, func, arg);
+        return;
+    }
+    RATE_OUTPUT out = { .decimator = dp -> decimator, .func = func, .arg = arg };
+    while (n > 0) {
+        size_t used = n;
+        size_t got = dtmf_decimator_run(dp -> decimator, p, &used, dp -> decimated, DECIMATOR_CHUNK);
+        feed_rate(dp, dp -> decimated, got, report_input_event, &out);
+        p += used;
+        n -= used;
+    }
+}
+
+void dtmf_detector_finish(DTMF_DETECTOR *dp, DTMF_EVENT_FUNC *func, void *arg) {
+    if (dp -> decimator == NULL) {
+        dtmf_tracker_finish(&dp -> tracker, func, arg);
+        return;
+    }
+    RATE_OUTPUT out = { .decimator = dp -> decimator, .func = func, .arg = arg };
+    size_t got;
+    while ((got = dtmf_decimator_finish(dp -> decimator, dp -> decimated, DECIMATOR_CHUNK)) > 0) {
+        feed_rate(dp, dp -> decimated, got, report_input_event, &out);
+    }
+    dtmf_tracker_finish(&dp -> tracker, report_input_event, &out);
+}
@@ -0,0 +1,207 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <math.h>
+#include <pthread.h>
+
+#include "audio_io.h"
+#include "const.h"
+#include "debug.h"
+#include "dtmf_generator.h"
+#include "dtmf_mix.h"
+
+struct dtmf_generator {
+    const DTMF_NOISE *noise;           // Noise source, or NULL if none.
+    DTMF_NOISE *own_noise;             // Noise source opened by the generator itself, if any.
+    size_t noise_pos;                  // Index of the next noise sample.
+    int noise_loop;
+    double w;                          // Weight of the noise in the mix.
+    int index;                         // Index of the next sample to be produced.
+    int16_t noise_buf[SAMPLE_BUF_SIZE];
+    double tone_buf[SAMPLE_BUF_SIZE];
+    uint8_t close_buf[SAMPLE_BUF_SIZE];
+};
+
+/*
+ * Cache of one period of the waveform cos(2 pi F i / AUDIO_FRAME_RATE) for each of
+ * the DTMF frequencies F.  Since the frequencies are whole numbers of Hz, each
+ * waveform repeats every AUDIO_FRAME_RATE samples (or some divisor of that).
+ * The tables are computed once, when a generator is first created, and are then
+ * only read, without locking, by all generators in all threads.
+ */
+static double tone_cache[NUM_DTMF_FREQS][AUDIO_FRAME_RATE];
+static pthread_once_t tone_cache_once = PTHREAD_ONCE_INIT;
+
+static void tone_cache_init(void) {
+    for (int F = 0; F < NUM_DTMF_FREQS; F++) {
+        double *wave = *(tone_cache + F);
+        int Fr = *(dtmf_freqs + F);
+        for (int i = 0; i < AUDIO_FRAME_RATE; i++) {
+            *(wave + i) = cos(2.0 * M_PI * Fr * i / AUDIO_FRAME_RATE);
+        }
+    }
+}
+
+/*
+ * Get the waveform table for DTMF frequency number F.
+ */
+static const double *tone_wave(int F) {
+    return *(tone_cache + F);
+}
+
+DTMF_GENERATOR *dtmf_generator_new(const DTMF_GENERATOR_CONFIG *cfg) {
+    pthread_once(&tone_cache_once, tone_cache_init);
+    DTMF_GENERATOR *gp = malloc(sizeof(DTMF_GENERATOR));
+    if (gp == NULL) {
+        return NULL;
+    }
+    gp -> noise = cfg -> noise;
+    gp -> own_noise = NULL;
+    gp -> noise_pos = 0;
+    gp -> noise_loop = cfg -> noise_loop;
+    gp -> w = pow(10, 0.1 * cfg -> noise_level) / (pow(10, 0.1 * cfg -> noise_level) + 1);
+    gp -> index = 0;
+    if (gp -> noise == NULL && cfg -> noise_file != NULL) {
+        gp -> noise = gp -> own_noise = dtmf_noise_open(cfg -> noise_file);
+        if (gp -> noise == NULL) {
+            dtmf_generator_free(gp);
+            return NULL;
+        }
+    }
+    return gp;
+}
+
+void dtmf_generator_free(DTMF_GENERATOR *gp) {
+    if (gp == NULL) {
+        return;
+    }
+    dtmf_noise_close(gp -> own_noise);
+    free(gp);
+}
+
+/*
+ * The tables give cos(2 pi F i / AUDIO_FRAME_RATE) as computed for i in
+ * [0, AUDIO_FRAME_RATE).  Computing it directly for larger i, as the original
+ * synthesis did, rounds the argument 2 pi F i / AUDIO_FRAME_RATE with a relative
+ * error of less than 4e-16, so the output samples, before conversion to integer,
+ * can differ by at most about 1.6e-11 per unit of i.  A sample whose value lies
+ * further than TONE_MARGIN(i) from an integer therefore converts to the same
+ * integer either way; the (rare) samples that lie closer are recomputed directly,
+ * so that the output is exactly the same as that of the original synthesis.
+ */
+#define TONE_MARGIN(i) (4e-11 * ((double)(i) + 1) + 1e-9)
+
+/*
+ * Look up the row and column frequency numbers of a DTMF symbol.
+ *
+ *   @return  0 if successful, EOF if symbol is not a DTMF symbol.
+ */
+static int find_tone(uint8_t symbol, int *r, int *c) {
+    for (int i = 0; i < NUM_DTMF_ROW_FREQS; i++) {
+        for (int j = 0; j < NUM_DTMF_COL_FREQS; j++) {
+            if (*(*(dtmf_symbol_names + i) + j) == symbol) {
+                *r = i;
+                *c = NUM_DTMF_ROW_FREQS + j;
+                return 0;
+            }
+        }
+    }
+    return EOF;
+}
+
+/*
+ * Sum of the row and column waveforms of a tone at sample index i, computed
+ * directly rather than from the tables.
+ */
+static double tone_direct(int Fr, int Fc, int i) {
+    double a = cos(2.0 * M_PI * Fr * i / AUDIO_FRAME_RATE);
+    double b = cos(2.0 * M_PI * Fc * i / AUDIO_FRAME_RATE);
+    return a + b;
+}
+
+
+/*
+ * Produce n samples, at most SAMPLE_BUF_SIZE, of silence (if r is -1) or of the
+ * tone composed of frequencies number r and c, mixed with noise if a noise source
+ * is in use.  Once the noise is exhausted, silence is silent and tones are
+ * produced at the level they would have had in the mix.
+ */
+static void render_chunk(DTMF_GENERATOR *gp, int r, int c, int16_t *samples, int n) {
+    int got = 0;
+    if (gp -> noise != NULL) {
+        got = dtmf_noise_read(gp -> noise, &gp -> noise_pos, gp -> noise_buf, n, gp -> noise_loop);
+    }
+    double w = gp -> w;
+    if (r < 0) {
+        for (int j = 0; j < n; j++) {
+            *(samples + j) = j < got ? (int16_t) (w * *(gp -> noise_buf + j)) : 0;
+        }
+        gp -> index += n;
+        return;
+    }
+    const double *wa = tone_wave(r);
+    const double *wb = tone_wave(c);
+    int k = gp -> index % AUDIO_FRAME_RATE;
+    for (int j = 0; j < n; ) {
+        int m = AUDIO_FRAME_RATE - k < n - j ? AUDIO_FRAME_RATE - k : n - j;
+        for (int l = 0; l < m; l++) {
+            *(gp -> tone_buf + j + l) = *(wa + k + l) + *(wb + k + l);
+        }
+        j += m;
+        k = 0;
+    }
+    // Without noise the tone is at full level; the noise weight is applied only to
+    // samples for which there is noise.
+    double tone_gain = gp -> noise != NULL ? 1 - w : 1;
+    double margin = TONE_MARGIN(gp -> index + n);
+    size_t flagged = dtmf_mix(gp -> tone_buf, gp -> noise_buf, w, tone_gain, margin,
+                              samples, gp -> close_buf, got);
+    flagged += dtmf_mix(gp -> tone_buf + got, NULL, 0, tone_gain, margin,
+                        samples + got, gp -> close_buf + got, n - got);
+    for (int j = 0; flagged > 0 && j < n; j++) {
+        if (*(gp -> close_buf + j)) {
+            int Fr = *(dtmf_freqs + r);
+            int Fc = *(dtmf_freqs + c);
+            double v = tone_direct(Fr, Fc, gp -> index + j) * 0.5 * INT16_MAX * tone_gain;
+            if (j < got) {
+                v = w * *(gp -> noise_buf + j) + v;
+            }
+            *(samples + j) = (int16_t) v;
+            flagged--;
+        }
+    }
+    gp -> index += n;
+}
+
+int dtmf_generator_silent(const DTMF_GENERATOR *gp) {
+    return gp -> noise == NULL
+        || (!gp -> noise_loop && gp -> noise_pos >= dtmf_noise_length(gp -> noise))
+        || dtmf_noise_length(gp -> noise) == 0;
+}
+
+void dtmf_generator_skip(DTMF_GENERATOR *gp, size_t n) {
+    if (gp -> noise != NULL) {
+        size_t len = dtmf_noise_length(gp -> noise);
+        if (gp -> noise_loop && len > 0) {
+            gp -> noise_pos = (gp -> noise_pos + n) % len;
+        } else {
+            gp -> noise_pos = gp -> noise_pos + n < len ? gp -> noise_pos + n : len;
+        }
+    }
+    gp -> index += n;
+}
+
+int dtmf_generator_render(DTMF_GENERATOR *gp, uint8_t symbol, int16_t *samples, size_t n) {
+    int r = -1;
+    int c = -1;
+    if (symbol != 0 && find_tone(symbol, &r, &c) == EOF) {
+        return EOF;
+    }
+    while (n > 0) {
+        int m = n < SAMPLE_BUF_SIZE ? n : SAMPLE_BUF_SIZE;
+        render_chunk(gp, r, c, samples, m);
+        samples += m;
+        n -= m;
+    }
+    return 0;
+}
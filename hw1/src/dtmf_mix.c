@@ -0,0 +1,107 @@
+#include <stdint.h>
+#include <math.h>
+
+#include "debug.h"
+#include "dtmf_mix.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define DTMF_MIX_X86
+#endif
+
+/*
+ * Mix one sample, as for dtmf_mix.
+ */
+static inline int16_t mix_one(double tone, const int16_t *noise, double noise_gain, double tone_gain,
+                              double margin, uint8_t *close) {
+    double v = tone * 0.5 * INT16_MAX * tone_gain;
+    if (noise != NULL) {
+        v = noise_gain * *noise + v;
+    }
+    double f = fabs(v - trunc(v));
+    *close = f < margin || f > 1 - margin;
+    if (v >= INT16_MAX) {
+        return INT16_MAX;
+    }
+    if (v <= INT16_MIN) {
+        return INT16_MIN;
+    }
+    return (int16_t)v;
+}
+
+static size_t mix_scalar(const double *tone, const int16_t *noise, double noise_gain, double tone_gain,
+                         double margin, int16_t *out, uint8_t *close, size_t n) {
+    size_t flagged = 0;
+    for (size_t j = 0; j < n; j++) {
+        *(out + j) = mix_one(*(tone + j), noise != NULL ? noise + j : NULL, noise_gain, tone_gain,
+                             margin, close + j);
+        flagged += *(close + j);
+    }
+    return flagged;
+}
+
+#ifdef DTMF_MIX_X86
+/*
+ * Four samples at a time.  Multiplications and additions are done in the same
+ * order as in the scalar version, and FMA is not enabled, so the results are
+ * the same; out-of-range results are clamped before the truncating conversion.
+ */
+__attribute__((target("avx")))
+static size_t mix_avx(const double *tone, const int16_t *noise, double noise_gain, double tone_gain,
+                      double margin, int16_t *out, uint8_t *close, size_t n) {
+    __m256d half = _mm256_set1_pd(0.5);
+    __m256d scale = _mm256_set1_pd(INT16_MAX);
+    __m256d tg = _mm256_set1_pd(tone_gain);
+    __m256d ng = _mm256_set1_pd(noise_gain);
+    __m256d lo = _mm256_set1_pd(margin);
+    __m256d hi = _mm256_set1_pd(1 - margin);
+    __m256d smin = _mm256_set1_pd(INT16_MIN);
+    __m256d smax = _mm256_set1_pd(INT16_MAX);
+    __m256d abs_mask = _mm256_castsi256_pd(_mm256_set1_epi64x(0x7fffffffffffffffLL));
+    size_t flagged = 0;
+    size_t j = 0;
+    for (; j + 4 <= n; j += 4) {
+        __m256d v = _mm256_mul_pd(_mm256_mul_pd(_mm256_mul_pd(_mm256_loadu_pd(tone + j), half), scale), tg);
+        if (noise != NULL) {
+            __m128i x = _mm_cvtepi16_epi32(_mm_loadl_epi64((const __m128i *)(noise + j)));
+            v = _mm256_add_pd(_mm256_mul_pd(ng, _mm256_cvtepi32_pd(x)), v);
+        }
+        __m256d f = _mm256_and_pd(_mm256_sub_pd(v, _mm256_round_pd(v, _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC)),
+                                  abs_mask);
+        int mask = _mm256_movemask_pd(_mm256_or_pd(_mm256_cmp_pd(f, lo, _CMP_LT_OQ),
+                                                   _mm256_cmp_pd(f, hi, _CMP_GT_OQ)));
+        v = _mm256_min_pd(_mm256_max_pd(v, smin), smax);
+        __m128i r = _mm256_cvttpd_epi32(v);
+        _mm_storel_epi64((__m128i *)(out + j), _mm_packs_epi32(r, r));
+        for (int l = 0; l < 4; l++) {
+            *(close + j + l) = (mask >> l) & 1;
+        }
+        flagged += __builtin_popcount(mask);
+    }
+    return flagged + mix_scalar(tone + j, noise != NULL ? noise + j : NULL, noise_gain, tone_gain,
+                                margin, out + j, close + j, n - j);
+}
+#endif
+
+/*
+ * Implementation of dtmf_mix, chosen once according to the capabilities of the CPU.
+ */
+static size_t (*mix_impl)(const double *, const int16_t *, double, double, double,
+                          int16_t *, uint8_t *, size_t);
+
+__attribute__((constructor))
+static void mix_select_impl(void) {
+    mix_impl = mix_scalar;
+#ifdef DTMF_MIX_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx")) {
+        mix_impl = mix_avx;
+    }
+    debug("dtmf mix: %s", mix_impl == mix_avx ? "avx" : "scalar");
+#endif
+}
+
+size_t dtmf_mix(const double *tone, const int16_t *noise, double noise_gain, double tone_gain,
+                double margin, int16_t *out, uint8_t *close, size_t n) {
+    return (*mix_impl)(tone, noise, noise_gain, tone_gain, margin, out, close, n);
+}
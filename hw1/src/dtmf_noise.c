@@ -0,0 +1,127 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "audio_io.h"
+#include "const.h"
+#include "debug.h"
+#include "dtmf_noise.h"
+
+struct dtmf_noise {
+    const uint8_t *data;  // The sample data, as encoded in the file.
+    uint32_t encoding;    // Encoding of the sample data (see audio.h).
+    size_t count;         // Number of samples.
+    void *map;            // The mapping of the whole file, or NULL if not mapped.
+    size_t map_size;
+    uint8_t *buf;         // The sample data as read into memory, if not mapped.
+};
+
+/*
+ * Read the rest of a stream into memory.
+ *
+ *   @return  0 if successful, EOF if there was a read error or not enough memory.
+ */
+static int read_all(FILE *f, uint8_t **bufp, size_t *sizep) {
+    uint8_t *buf = NULL;
+    size_t size = 0;
+    size_t cap = 0;
+    while (1) {
+        if (size == cap) {
+            cap = cap ? 2 * cap : 65536;
+            uint8_t *more = realloc(buf, cap);
+            if (more == NULL) {
+                free(buf);
+                return EOF;
+            }
+            buf = more;
+        }
+        size_t got = fread(buf + size, 1, cap - size, f);
+        if (got == 0) {
+            break;
+        }
+        size += got;
+    }
+    if (ferror(f)) {
+        free(buf);
+        return EOF;
+    }
+    *bufp = buf;
+    *sizep = size;
+    return 0;
+}
+
+DTMF_NOISE *dtmf_noise_open(const char *path) {
+    DTMF_NOISE *np = calloc(1, sizeof(DTMF_NOISE));
+    FILE *f = fopen(path, "r");
+    AUDIO_HEADER hd;
+    if (np == NULL || f == NULL || audio_read_header(f, &hd) == EOF
+        || hd.channels != AUDIO_CHANNELS || hd.sample_rate != AUDIO_FRAME_RATE) {
+        free(np);
+        if (f != NULL) {
+            fclose(f);
+        }
+        return NULL;
+    }
+    np -> encoding = hd.encoding;
+    size_t sample_size = audio_sample_size(hd.encoding);
+    struct stat st;
+    off_t offset = ftello(f);
+    if (offset != -1 && fstat(fileno(f), &st) == 0 && S_ISREG(st.st_mode) && st.st_size > offset) {
+        void *map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fileno(f), 0);
+        if (map != MAP_FAILED) {
+            np -> map = map;
+            np -> map_size = st.st_size;
+            np -> data = (uint8_t *)map + offset;
+            np -> count = (st.st_size - offset) / sample_size;
+        }
+    }
+    if (np -> map == NULL) {
+        size_t size;
+        if (read_all(f, &np -> buf, &size) == EOF) {
+            fclose(f);
+            free(np);
+            return NULL;
+        }
+        np -> data = np -> buf;
+        np -> count = size / sample_size;
+    }
+    fclose(f);
+    return np;
+}
+
+size_t dtmf_noise_length(const DTMF_NOISE *np) {
+    return np -> count;
+}
+
+size_t dtmf_noise_read(const DTMF_NOISE *np, size_t *posp, int16_t *samples, size_t n, int loop) {
+    size_t pos = *posp;
+    size_t done = 0;
+    while (done < n && np -> count > 0) {
+        if (pos >= np -> count) {
+            if (!loop) {
+                break;
+            }
+            pos = 0;
+        }
+        size_t m = np -> count - pos < n - done ? np -> count - pos : n - done;
+        audio_expand_samples(np -> encoding, np -> data + pos * audio_sample_size(np -> encoding),
+                             samples + done, m);
+        pos += m;
+        done += m;
+    }
+    *posp = pos;
+    return done;
+}
+
+void dtmf_noise_close(DTMF_NOISE *np) {
+    if (np == NULL) {
+        return;
+    }
+    if (np -> map != NULL) {
+        munmap(np -> map, np -> map_size);
+    }
+    free(np -> buf);
+    free(np);
+}
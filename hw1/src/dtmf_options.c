@@ -0,0 +1,21 @@
+#include <stdint.h>
+#include <stdio.h>
+
+#include "dtmf_options.h"
+
+int hop_size;
+int goertzel_engine;
+int coarse_size;
+int tone_families;
+int num_jobs;
+int stream_mode;
+int pipeline_mode;
+int batch_mode;
+char **batch_files;
+int batch_count;
+char *sidecar_file;
+char *redecide_file;
+char *thresholds_spec;
+char *sweep_spec;
+
+int16_t sample_buf[SAMPLE_BUF_SIZE];
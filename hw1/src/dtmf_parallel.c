@@ -0,0 +1,270 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "audio_io.h"
+#include "const.h"
+#include "debug.h"
+#include "dtmf_analysis.h"
+#include "dtmf_parallel.h"
+
+/*
+ * Work assignment for one worker thread: the blocks with indices in [first, last).
+ */
+typedef struct detect_chunk {
+    const uint8_t *data;          // Start of the sample data in the mapped file.
+    uint32_t encoding;            // Encoding of the sample data (see audio.h).
+    const GOERTZEL_PLAN *plans;   // Plans for the DTMF frequencies at the block size.
+    int engine;                   // Goertzel engine to use.
+    size_t first;
+    size_t last;
+    uint8_t *symbols;             // Receives the decision for each block.
+} DETECT_CHUNK;
+
+static void *detect_worker(void *arg) {
+    DETECT_CHUNK *cp = arg;
+    int N = cp -> plans -> N;
+    int16_t samples[N];
+    double strengths[NUM_DTMF_FREQS];
+    size_t size = audio_sample_size(cp -> encoding);
+    for (size_t b = cp -> first; b < cp -> last; b++) {
+        audio_expand_samples(cp -> encoding, cp -> data + b * N * size, samples, N);
+        if (dtmf_block_quiet(samples, N)) {
+            *(cp -> symbols + b) = 0;
+        } else {
+            *(cp -> symbols + b) = dtmf_analyze_block(cp -> plans, cp -> engine, samples, strengths);
+        }
+    }
+    return NULL;
+}
+
+int dtmf_parallel_ok(FILE *audio_in) {
+    struct stat st;
+    return fstat(fileno(audio_in), &st) == 0 && S_ISREG(st.st_mode);
+}
+
+int dtmf_detect_parallel(FILE *audio_in, const DTMF_DETECTOR_CONFIG *cfg, int jobs,
+                         DTMF_EVENT_FUNC *func, void *arg) {
+    struct stat st;
+    int block_size = cfg -> block_size;
+    DTMF_TRACKER tracker;
+    off_t offset = ftello(audio_in);
+    if ((cfg -> sample_rate != 0 && cfg -> sample_rate != AUDIO_FRAME_RATE)
+        || offset == -1 || fstat(fileno(audio_in), &st) == -1) {
+        return EOF;
+    }
+    size_t nblocks = 0;
+    if (st.st_size > offset) {
+        nblocks = (st.st_size - offset) / audio_sample_size(cfg -> encoding) / block_size;
+    }
+    if (nblocks == 0) {
+        return 0;
+    }
+    uint8_t *map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fileno(audio_in), 0);
+    if (map == MAP_FAILED) {
+        return EOF;
+    }
+    madvise(map, st.st_size, MADV_SEQUENTIAL);
+    GOERTZEL_PLAN plans[NUM_DTMF_FREQS];
+    dtmf_plans_init(plans, block_size);
+    int engine = dtmf_engine_select(cfg -> engine, NUM_DTMF_FREQS, block_size);
+    uint8_t *symbols = malloc(nblocks);
+    if ((size_t)jobs > nblocks) {
+        jobs = nblocks;
+    }
+    pthread_t threads[jobs];
+    DETECT_CHUNK chunks[jobs];
+    int started = 0;
+    int ret = symbols != NULL ? 0 : EOF;
+    for (int j = 0; j < jobs && ret == 0; j++) {
+        DETECT_CHUNK *cp = chunks + j;
+        cp -> data = map + offset;
+        cp -> encoding = cfg -> encoding;
+        cp -> plans = plans;
+        cp -> engine = engine;
+        cp -> first = nblocks * j / jobs;
+        cp -> last = nblocks * (j + 1) / jobs;
+        cp -> symbols = symbols;
+        if (pthread_create(threads + j, NULL, detect_worker, cp) != 0) {
+            ret = EOF;
+        } else {
+            started++;
+        }
+    }
+    for (int j = 0; j < started; j++) {
+        pthread_join(*(threads + j), NULL);
+    }
+    if (ret == 0) {
+        dtmf_tracker_init(&tracker, block_size);
+        for (size_t b = 0; b < nblocks; b++) {
+            dtmf_tracker_window(&tracker, b * block_size, *(symbols + b), func, arg);
+        }
+        dtmf_tracker_finish(&tracker, func, arg);
+    }
+    free(symbols);
+    munmap(map, st.st_size);
+    return ret;
+}
+
+/*
+ * Work assignment for one generation worker: the samples with indices in [first, last).
+ */
+typedef struct generate_segment {
+    const DTMF_SCRIPT *script;
+    const DTMF_GENERATOR_CONFIG *cfg;
+    int fd;
+    off_t base;       // File offset of the sample with index 0.
+    off_t eof;        // Size of the file before generation began.
+    uint32_t first;
+    uint32_t last;
+    int ret;
+} GENERATE_SEGMENT;
+
+/*
+ * Write bytes at an offset, retrying after partial writes.
+ */
+static int pwrite_all(int fd, const void *buf, size_t size, off_t offset) {
+    const char *p = buf;
+    while (size > 0) {
+        ssize_t n = pwrite(fd, p, size, offset);
+        if (n <= 0) {
+            return EOF;
+        }
+        p += n;
+        size -= n;
+        offset += n;
+    }
+    return 0;
+}
+
+/*
+ * Write count samples of the specified symbol (or silence), starting at sample
+ * index from, in chunks of at most SAMPLE_BUF_SIZE.
+ */
+static int segment_write(GENERATE_SEGMENT *gp, DTMF_GENERATOR *gen, int16_t *buf,
+                         uint8_t symbol, uint32_t from, uint32_t count) {
+    off_t offset = gp -> base + (off_t)from * AUDIO_BYTES_PER_SAMPLE;
+    if (symbol == 0 && dtmf_generator_silent(gen)) {
+        dtmf_generator_skip(gen, count);
+        if (offset >= gp -> eof) {
+            return 0;  // a hole, which reads as zeros
+        }
+        for (uint32_t i = 0; i < count && i < SAMPLE_BUF_SIZE; i++) {
+            *(buf + i) = 0;
+        }
+        while (count > 0) {
+            uint32_t n = count < SAMPLE_BUF_SIZE ? count : SAMPLE_BUF_SIZE;
+            if (pwrite_all(gp -> fd, buf, n * AUDIO_BYTES_PER_SAMPLE, offset) == EOF) {
+                return EOF;
+            }
+            offset += n * AUDIO_BYTES_PER_SAMPLE;
+            count -= n;
+        }
+        return 0;
+    }
+    while (count > 0) {
+        uint32_t n = count < SAMPLE_BUF_SIZE ? count : SAMPLE_BUF_SIZE;
+        if (dtmf_generator_render(gen, symbol, buf, n) == EOF) {
+            return EOF;
+        }
+        audio_encode_samples(buf, n);
+        if (pwrite_all(gp -> fd, buf, n * AUDIO_BYTES_PER_SAMPLE, offset) == EOF) {
+            return EOF;
+        }
+        offset += n * AUDIO_BYTES_PER_SAMPLE;
+        count -= n;
+    }
+    return 0;
+}
+
+static void *generate_worker(void *arg) {
+    GENERATE_SEGMENT *gp = arg;
+    const DTMF_SCRIPT *sp = gp -> script;
+    DTMF_GENERATOR *gen = dtmf_generator_new(gp -> cfg);
+    int16_t buf[SAMPLE_BUF_SIZE];
+    if (gen == NULL) {
+        gp -> ret = EOF;
+        return NULL;
+    }
+    dtmf_generator_skip(gen, gp -> first);
+    uint32_t pos = gp -> first;
+    size_t k = dtmf_script_find(sp, pos);
+    while (pos < gp -> last && gp -> ret == 0) {
+        const DTMF_EVENT *ep = k < sp -> count ? sp -> events + k : NULL;
+        uint8_t symbol = 0;
+        uint32_t next = gp -> last;
+        if (ep != NULL && ep -> start <= pos) {
+            symbol = ep -> symbol;
+            next = ep -> end < next ? ep -> end : next;
+            k++;
+        } else if (ep != NULL && ep -> start < next) {
+            next = ep -> start;
+        }
+        gp -> ret = segment_write(gp, gen, buf, symbol, pos, next - pos);
+        pos = next;
+    }
+    dtmf_generator_free(gen);
+    return NULL;
+}
+
+int dtmf_generate_parallel(FILE *audio_out, const DTMF_SCRIPT *sp, const DTMF_GENERATOR_CONFIG *cfg,
+                           int jobs) {
+    struct stat st;
+    int fd = fileno(audio_out);
+    if (fflush(audio_out) == EOF || fstat(fd, &st) == -1) {
+        return EOF;
+    }
+    off_t base = ftello(audio_out);
+    if (base == -1) {
+        return EOF;
+    }
+    uint32_t length = sp -> length;
+    // Segments are whole numbers of SAMPLE_BUF_SIZE samples, so that they meet at
+    // block boundaries in the file.
+    uint32_t chunks = (length + SAMPLE_BUF_SIZE - 1) / SAMPLE_BUF_SIZE;
+    if ((uint32_t)jobs > chunks) {
+        jobs = chunks > 0 ? chunks : 1;
+    }
+    pthread_t threads[jobs];
+    GENERATE_SEGMENT segments[jobs];
+    int started = 0;
+    int ret = 0;
+    for (int j = 0; j < jobs; j++) {
+        GENERATE_SEGMENT *gp = segments + j;
+        gp -> script = sp;
+        gp -> cfg = cfg;
+        gp -> fd = fd;
+        gp -> base = base;
+        gp -> eof = st.st_size;
+        gp -> first = (uint64_t)chunks * j / jobs * SAMPLE_BUF_SIZE;
+        gp -> last = (uint64_t)chunks * (j + 1) / jobs * SAMPLE_BUF_SIZE;
+        if (gp -> last > length) {
+            gp -> last = length;
+        }
+        gp -> ret = 0;
+        if (pthread_create(threads + j, NULL, generate_worker, gp) != 0) {
+            ret = EOF;
+            break;
+        }
+        started++;
+    }
+    for (int j = 0; j < started; j++) {
+        pthread_join(*(threads + j), NULL);
+        if ((segments + j) -> ret == EOF) {
+            ret = EOF;
+        }
+    }
+    // Extend the file over any hole at the end, and leave the stream after the samples.
+    off_t end = base + (off_t)length * AUDIO_BYTES_PER_SAMPLE;
+    if (fstat(fd, &st) == 0 && st.st_size < end && ftruncate(fd, end) == -1) {
+        ret = EOF;
+    }
+    if (fseeko(audio_out, end, SEEK_SET) == -1) {
+        ret = EOF;
+    }
+    return ret;
+}
@@ -0,0 +1,229 @@
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "audio_io.h"
+#include "const.h"
+#include "debug.h"
+#include "dtmf_pipeline.h"
+
+/*
+ * A single-producer, single-consumer ring of fixed-size slots.  head counts the
+ * slots ever filled and tail the slots ever emptied; each is written by only one
+ * side, and read by the other with acquire ordering, so that the contents of a
+ * slot are visible before the index that hands it over.  The two indices are
+ * kept in separate cache lines so that the two sides do not contend for one.
+ */
+typedef struct pipeline_ring {
+    _Alignas(64) atomic_size_t head;
+    _Alignas(64) atomic_size_t tail;
+    size_t nslots;
+    size_t slot_size;
+    char *slots;
+} PIPELINE_RING;
+
+/*
+ * A slot of samples.  A count of 0 marks the end of the input, EOF a read error.
+ */
+typedef struct sample_slot {
+    int count;
+    int16_t samples[PIPELINE_SLOT_SAMPLES];
+} SAMPLE_SLOT;
+
+/*
+ * A slot of the event ring: an event if status is 0, otherwise the end of the
+ * events, with status 1 at the end of the input and EOF after a read error.
+ */
+typedef struct event_slot {
+    int status;
+    int start;
+    int end;
+    uint8_t symbol;
+} EVENT_SLOT;
+
+typedef struct pipeline {
+    int fd;
+    uint32_t encoding;
+    DTMF_DETECTOR *dp;
+    PIPELINE_RING samples;
+    PIPELINE_RING events;
+} PIPELINE;
+
+static int ring_init(PIPELINE_RING *rp, size_t nslots, size_t slot_size) {
+    atomic_init(&rp -> head, 0);
+    atomic_init(&rp -> tail, 0);
+    rp -> nslots = nslots;
+    rp -> slot_size = slot_size;
+    rp -> slots = malloc(nslots * slot_size);
+    return rp -> slots != NULL ? 0 : EOF;
+}
+
+/*
+ * Wait a little longer each time a ring is found full or empty: spin at first,
+ * for the common case in which the other side is about to catch up, then yield,
+ * then sleep, for up to a millisecond at a time, so that an idle stage on a
+ * live stream costs almost nothing.
+ */
+static void ring_backoff(int spins) {
+    if (spins < 64) {
+        return;
+    }
+    if (spins < 128) {
+        sched_yield();
+        return;
+    }
+    long ns = 50000L << (spins - 128 < 4 ? spins - 128 : 4);
+    struct timespec ts = { .tv_sec = 0, .tv_nsec = ns < 1000000L ? ns : 1000000L };
+    nanosleep(&ts, NULL);
+}
+
+/*
+ * Producer side: wait for a free slot and return it, to be filled and then
+ * handed over with ring_publish.
+ */
+static void *ring_claim(PIPELINE_RING *rp) {
+    size_t head = atomic_load_explicit(&rp -> head, memory_order_relaxed);
+    for (int spins = 0; head - atomic_load_explicit(&rp -> tail, memory_order_acquire) == rp -> nslots;
+         spins++) {
+        ring_backoff(spins);
+    }
+    return rp -> slots + (head % rp -> nslots) * rp -> slot_size;
+}
+
+static void ring_publish(PIPELINE_RING *rp) {
+    atomic_fetch_add_explicit(&rp -> head, 1, memory_order_release);
+}
+
+/*
+ * Consumer side: wait for a filled slot and return it, to be handed back with
+ * ring_release once it is no longer needed.
+ */
+static void *ring_peek(PIPELINE_RING *rp) {
+    size_t tail = atomic_load_explicit(&rp -> tail, memory_order_relaxed);
+    for (int spins = 0; atomic_load_explicit(&rp -> head, memory_order_acquire) == tail; spins++) {
+        ring_backoff(spins);
+    }
+    return rp -> slots + (tail % rp -> nslots) * rp -> slot_size;
+}
+
+static void ring_release(PIPELINE_RING *rp) {
+    atomic_fetch_add_explicit(&rp -> tail, 1, memory_order_release);
+}
+
+static void end_samples(PIPELINE *pp, int count) {
+    SAMPLE_SLOT *sp = ring_claim(&pp -> samples);
+    sp -> count = count;
+    ring_publish(&pp -> samples);
+}
+
+/*
+ * Reader stage: read whatever data is available into the next free slot, and
+ * hand it over as soon as it has been decoded.  An odd byte left at the end of
+ * a read of two-byte samples is carried over to the start of the next slot.
+ */
+static void *reader_stage(void *arg) {
+    PIPELINE *pp = arg;
+    size_t size = audio_sample_size(pp -> encoding);
+    int carry = -1;
+    while (1) {
+        SAMPLE_SLOT *sp = ring_claim(&pp -> samples);
+        char *bytes = (char *)sp -> samples;
+        size_t have = 0;
+        if (carry != -1) {
+            *bytes = (char)carry;
+            have = 1;
+        }
+        ssize_t r;
+        do {
+            r = read(pp -> fd, bytes + have, PIPELINE_SLOT_SAMPLES * size - have);
+        } while (r == -1 && errno == EINTR);
+        if (r <= 0) {
+            sp -> count = r == 0 ? 0 : EOF;
+            ring_publish(&pp -> samples);
+            return NULL;
+        }
+        have += r;
+        sp -> count = have / size;
+        carry = have % size ? (unsigned char)*(bytes + have - 1) : -1;
+        if (sp -> count > 0) {
+            audio_expand_samples(pp -> encoding, sp -> samples, sp -> samples, sp -> count);
+            ring_publish(&pp -> samples);
+        }
+    }
+}
+
+static void push_event(void *arg, int start, int end, uint8_t symbol) {
+    PIPELINE *pp = arg;
+    EVENT_SLOT *ep = ring_claim(&pp -> events);
+    ep -> status = 0;
+    ep -> start = start;
+    ep -> end = end;
+    ep -> symbol = symbol;
+    ring_publish(&pp -> events);
+}
+
+/*
+ * Filter stage: feed each slot of samples to the detector, passing on the events
+ * that it reports, until the end of the input.
+ */
+static void *filter_stage(void *arg) {
+    PIPELINE *pp = arg;
+    int count;
+    do {
+        SAMPLE_SLOT *sp = ring_peek(&pp -> samples);
+        count = sp -> count;
+        if (count > 0) {
+            dtmf_detector_feed(pp -> dp, sp -> samples, count, push_event, pp);
+        }
+        ring_release(&pp -> samples);
+    } while (count > 0);
+    if (count == 0) {
+        dtmf_detector_finish(pp -> dp, push_event, pp);
+    }
+    EVENT_SLOT *ep = ring_claim(&pp -> events);
+    ep -> status = count == 0 ? 1 : EOF;
+    ring_publish(&pp -> events);
+    return NULL;
+}
+
+int dtmf_detect_pipeline(FILE *audio_in, uint32_t encoding, DTMF_DETECTOR *dp,
+                         DTMF_EVENT_FUNC *func, void *arg) {
+    PIPELINE pipeline = { .fd = fileno(audio_in), .encoding = encoding, .dp = dp };
+    PIPELINE *pp = &pipeline;
+    int ret = EOF;
+    if (ring_init(&pp -> samples, PIPELINE_SAMPLE_SLOTS, sizeof(SAMPLE_SLOT)) == 0
+        && ring_init(&pp -> events, PIPELINE_EVENT_SLOTS, sizeof(EVENT_SLOT)) == 0) {
+        pthread_t filter, reader;
+        if (pthread_create(&filter, NULL, filter_stage, pp) == 0) {
+            // If the reader cannot be started, the filters are stopped as if it had
+            // failed to read.
+            int reading = pthread_create(&reader, NULL, reader_stage, pp) == 0;
+            if (!reading) {
+                end_samples(pp, EOF);
+            }
+            while (1) {
+                EVENT_SLOT *ep = ring_peek(&pp -> events);
+                if (ep -> status != 0) {
+                    ret = ep -> status == 1 ? 0 : EOF;
+                    ring_release(&pp -> events);
+                    break;
+                }
+                func(arg, ep -> start, ep -> end, ep -> symbol);
+                ring_release(&pp -> events);
+            }
+            if (reading) {
+                pthread_join(reader, NULL);
+            }
+            pthread_join(filter, NULL);
+        }
+    }
+    free(pp -> samples.slots);
+    free(pp -> events.slots);
+    return ret;
+}
@@ -0,0 +1,204 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "audio_io.h"
+#include "const.h"
+#include "debug.h"
+#include "dtmf_analysis.h"
+#include "dtmf_parallel.h"
+#include "dtmf_refine.h"
+
+/*
+ * The sample data of the input, as encoded in the file, either mapped from a
+ * regular file or read into a buffer.
+ */
+typedef struct refine_input {
+    uint8_t *base;       // Start of the mapping or buffer.
+    size_t size;         // Size of the mapping or buffer.
+    const uint8_t *data; // Start of the sample data.
+    uint32_t encoding;   // Encoding of the sample data (see audio.h).
+    size_t nsamples;     // Number of complete samples.
+    int mapped;
+} REFINE_INPUT;
+
+static int input_open(REFINE_INPUT *ip, FILE *audio_in, uint32_t encoding) {
+    struct stat st;
+    size_t sample_size = audio_sample_size(encoding);
+    ip -> encoding = encoding;
+    ip -> mapped = dtmf_parallel_ok(audio_in);
+    if (ip -> mapped) {
+        off_t offset = ftello(audio_in);
+        if (offset == -1 || fstat(fileno(audio_in), &st) == -1) {
+            return EOF;
+        }
+        ip -> size = st.st_size;
+        ip -> nsamples = st.st_size > offset ? (st.st_size - offset) / sample_size : 0;
+        if (ip -> nsamples == 0) {
+            ip -> base = NULL;
+            ip -> data = NULL;
+            return 0;
+        }
+        ip -> base = mmap(NULL, ip -> size, PROT_READ, MAP_PRIVATE, fileno(audio_in), 0);
+        if (ip -> base == MAP_FAILED) {
+            return EOF;
+        }
+        madvise(ip -> base, ip -> size, MADV_SEQUENTIAL);
+        ip -> data = ip -> base + offset;
+        return 0;
+    }
+    size_t cap = 1 << 16;
+    size_t fill = 0;
+    ip -> base = malloc(cap);
+    while (ip -> base != NULL) {
+        fill += fread(ip -> base + fill, 1, cap - fill, audio_in);
+        if (fill < cap) {
+            break;
+        }
+        uint8_t *more = realloc(ip -> base, 2 * cap);
+        if (more == NULL) {
+            free(ip -> base);
+            ip -> base = NULL;
+            break;
+        }
+        ip -> base = more;
+        cap *= 2;
+    }
+    if (ip -> base == NULL || ferror(audio_in)) {
+        free(ip -> base);
+        return EOF;
+    }
+    ip -> size = cap;
+    ip -> data = ip -> base;
+    ip -> nsamples = fill / sample_size;
+    return 0;
+}
+
+static void input_close(REFINE_INPUT *ip) {
+    if (ip -> mapped) {
+        if (ip -> base != NULL) {
+            munmap(ip -> base, ip -> size);
+        }
+    } else {
+        free(ip -> base);
+    }
+}
+
+/*
+ * Decide which DTMF tone, if any, is present in the block of plans -> N samples
+ * starting at the specified index.
+ */
+static uint8_t block_decide(const GOERTZEL_PLAN *plans, int engine, const REFINE_INPUT *ip,
+                            size_t index, int16_t *samples) {
+    int N = plans -> N;
+    double strengths[NUM_DTMF_FREQS];
+    audio_expand_samples(ip -> encoding, ip -> data + index * audio_sample_size(ip -> encoding),
+                         samples, N);
+    if (dtmf_block_quiet(samples, N)) {
+        return 0;
+    }
+    return dtmf_analyze_block(plans, engine, samples, strengths);
+}
+
+/*
+ * Decide which of the candidate symbols (up to three, the decisions for a coarse block
+ * and its neighbours, with 0 for none) is present in the fine block of plans -> N
+ * samples starting at the specified index.  A fine block is too short to tell the
+ * DTMF frequencies apart as dtmf_classify_strengths requires, but it need only
+ * confirm a tone that the coarse pass has already identified: the row and column
+ * strengths of the candidate must pass the MINUS_20DB and FOUR_DB tests, and carry
+ * at least DTMF_REFINE_SHARE of the power of the block.  If more than one candidate
+ * qualifies, the strongest is chosen.
+ */
+static uint8_t block_confirm(const GOERTZEL_PLAN *plans, int engine, const REFINE_INPUT *ip,
+                             size_t index, int16_t *samples, const uint8_t *candidates) {
+    int N = plans -> N;
+    double strengths[NUM_DTMF_FREQS];
+    audio_expand_samples(ip -> encoding, ip -> data + index * audio_sample_size(ip -> encoding),
+                         samples, N);
+    int64_t energy = dtmf_block_energy(samples, N);
+    if (dtmf_energy_quiet(energy, N)) {
+        return 0;
+    }
+    dtmf_analyze_block(plans, engine, samples, strengths);
+    // The power of the block on the same scale as the strengths: 2E/N for normalized samples.
+    double power = 2.0 * energy / N / ((double)INT16_MAX * INT16_MAX);
+    uint8_t best = 0;
+    double best_strength = 0;
+    for (int r = 0; r < NUM_DTMF_ROW_FREQS; r++) {
+        for (int c = 0; c < NUM_DTMF_COL_FREQS; c++) {
+            uint8_t symbol = *(*(dtmf_symbol_names + r) + c);
+            if (symbol != *candidates && symbol != *(candidates + 1) && symbol != *(candidates + 2)) {
+                continue;
+            }
+            double row = *(strengths + r);
+            double col = *(strengths + NUM_DTMF_ROW_FREQS + c);
+            double strength = row + col;
+            if (strength < MINUS_20DB || strength < DTMF_REFINE_SHARE * power
+                || row > col * FOUR_DB || col > row * FOUR_DB) {
+                continue;
+            }
+            if (strength > best_strength) {
+                best_strength = strength;
+                best = symbol;
+            }
+        }
+    }
+    return best;
+}
+
+int dtmf_detect_refine(FILE *audio_in, const DTMF_DETECTOR_CONFIG *cfg, int coarse,
+                       DTMF_EVENT_FUNC *func, void *arg) {
+    REFINE_INPUT input;
+    if ((cfg -> sample_rate != 0 && cfg -> sample_rate != AUDIO_FRAME_RATE)
+        || input_open(&input, audio_in, cfg -> encoding) == EOF) {
+        return EOF;
+    }
+    int N = cfg -> block_size;
+    int R = coarse / N;                 // Fine blocks per coarse block.
+    size_t nfine = input.nsamples / N;
+    size_t ncoarse = nfine / R;
+    GOERTZEL_PLAN fine_plans[NUM_DTMF_FREQS];
+    GOERTZEL_PLAN coarse_plans[NUM_DTMF_FREQS];
+    dtmf_plans_init(fine_plans, N);
+    dtmf_plans_init(coarse_plans, coarse);
+    int coarse_engine = dtmf_engine_select(cfg -> engine, NUM_DTMF_FREQS, coarse);
+    int fine_engine = dtmf_engine_select(cfg -> engine, NUM_DTMF_FREQS, N);
+    int16_t samples[coarse];
+    // The decision for coarse block j is at position j + 1, with "no tone" before the
+    // first and after the last.  A fine block beyond the last complete coarse block
+    // looks at positions ncoarse to ncoarse + 2, so there are two such positions after.
+    uint8_t *decisions = malloc(ncoarse + 3);
+    if (decisions == NULL) {
+        input_close(&input);
+        return EOF;
+    }
+    *decisions = 0;
+    for (size_t j = 0; j < ncoarse; j++) {
+        *(decisions + j + 1) = block_decide(coarse_plans, coarse_engine, &input, j * coarse, samples);
+    }
+    *(decisions + ncoarse + 1) = 0;
+    *(decisions + ncoarse + 2) = 0;
+    DTMF_TRACKER tracker;
+    dtmf_tracker_init(&tracker, N);
+    size_t refined = 0;
+    for (size_t b = 0; b < nfine; b++) {
+        size_t j = b / R;
+        const uint8_t *dp = decisions + (j < ncoarse ? j : ncoarse);
+        uint8_t symbol;
+        if (*dp == *(dp + 1) && *(dp + 2) == *(dp + 1)) {
+            symbol = *(dp + 1);
+        } else {
+            symbol = block_confirm(fine_plans, fine_engine, &input, b * N, samples, dp);
+            refined++;
+        }
+        dtmf_tracker_window(&tracker, b * N, symbol, func, arg);
+    }
+    dtmf_tracker_finish(&tracker, func, arg);
+    debug("refine: %zu of %zu fine blocks analyzed", refined, nfine);
+    free(decisions);
+    input_close(&input);
+    return 0;
+}
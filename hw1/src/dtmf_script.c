@@ -0,0 +1,211 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "debug.h"
+#include "dtmf.h"
+#include "dtmf_script.h"
+
+/*
+ * Size of the blocks in which event input is read.  A line may be at most this long.
+ */
+#define SCRIPT_BUF_SIZE 65536
+
+/*
+ * State carried from one block of event input to the next.
+ */
+typedef struct script_parser {
+    DTMF_SCRIPT *sp;
+    uint32_t length;    // Number of samples to be written.
+    uint32_t last_end;  // End index of the previous event, as given.
+    size_t line;        // Number of the line being parsed, from 1.
+    uint8_t valid[256]; // Nonzero for each character that is a DTMF symbol.
+} SCRIPT_PARSER;
+
+/*
+ * Parse a decimal index of at least one digit that fits in 32 bits.
+ */
+static int parse_index(const char **pp, uint32_t *vp) {
+    const char *p = *pp;
+    uint64_t v = 0;
+    if (*p < '0' || *p > '9') {
+        return EOF;
+    }
+    while (*p >= '0' && *p <= '9') {
+        v = v * 10 + (*p++ - '0');
+        if (v > UINT32_MAX) {
+            return EOF;
+        }
+    }
+    *pp = p;
+    *vp = v;
+    return 0;
+}
+
+/*
+ * Parse the complete lines in [p, end), the last of which ends with a newline.
+ *
+ *   @return  0 to continue with the next block, 1 if the rest of the input is to be
+ *   ignored, EOF if there was an error.
+ */
+static int parse_lines(SCRIPT_PARSER *pp, const char *p, const char *end) {
+    DTMF_SCRIPT *sp = pp -> sp;
+    for (; p < end; pp -> line++) {
+        uint32_t start, stop;
+        uint8_t symbol;
+        if (parse_index(&p, &start) == EOF || *p++ != '\t' ||
+            parse_index(&p, &stop) == EOF || *p++ != '\t' ||
+            (symbol = *p++) == '\n') {
+            fprintf(stderr, "Malformed event at line %zu\n", pp -> line);
+            sp -> length = pp -> last_end;
+            return EOF;
+        }
+        while (*p == ' ' || *p == '\t' || *p == '\r') {
+            p++;
+        }
+        if (*p++ != '\n') {
+            fprintf(stderr, "Malformed event at line %zu\n", pp -> line);
+            sp -> length = pp -> last_end;
+            return EOF;
+        }
+        if (pp -> last_end > start || start >= stop) {
+            fprintf(stderr, "Overlapping error\n");
+            sp -> length = pp -> last_end;
+            return EOF;
+        }
+        if (start >= pp -> length) {
+            return 1;
+        }
+        if (!*(pp -> valid + symbol)) {
+            fprintf(stderr, "Invalid DTMF symbol at line %zu\n", pp -> line);
+            sp -> length = start;
+            return EOF;
+        }
+        if (dtmf_script_add(sp, start, stop < pp -> length ? stop : pp -> length, symbol) == EOF) {
+            sp -> length = start;
+            return EOF;
+        }
+        pp -> last_end = stop;
+        if (stop >= pp -> length) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+void dtmf_script_init(DTMF_SCRIPT *sp) {
+    sp -> events = NULL;
+    sp -> count = 0;
+    sp -> cap = 0;
+    sp -> length = 0;
+}
+
+int dtmf_script_add(DTMF_SCRIPT *sp, uint32_t start, uint32_t end, uint8_t symbol) {
+    if (sp -> count == sp -> cap) {
+        size_t cap = sp -> cap ? 2 * sp -> cap : 1024;
+        DTMF_EVENT *more = realloc(sp -> events, cap * sizeof(DTMF_EVENT));
+        if (more == NULL) {
+            return EOF;
+        }
+        sp -> events = more;
+        sp -> cap = cap;
+    }
+    DTMF_EVENT *ep = sp -> events + sp -> count++;
+    ep -> start = start;
+    ep -> end = end;
+    ep -> symbol = symbol;
+    return 0;
+}
+
+/*
+ * Read a script, as for dtmf_script_read, passing the events to func, if not NULL,
+ * after each block of input has been parsed, and then removing them from the script.
+ */
+static int read_script(DTMF_SCRIPT *sp, FILE *in, uint32_t length, DTMF_SCRIPT_FUNC *func,
+                       void *arg) {
+    SCRIPT_PARSER parser = { .sp = sp, .length = length, .line = 1 };
+    for (int i = 0; i < NUM_DTMF_ROW_FREQS; i++) {
+        for (int j = 0; j < NUM_DTMF_COL_FREQS; j++) {
+            *(parser.valid + *(*(dtmf_symbol_names + i) + j)) = 1;
+        }
+    }
+    sp -> length = length;
+    // One byte beyond the block, for a newline to terminate an unterminated last line.
+    char *buf = malloc(SCRIPT_BUF_SIZE + 1);
+    if (buf == NULL) {
+        sp -> length = 0;
+        return EOF;
+    }
+    size_t fill = 0;
+    int ret = 0;
+    while (ret == 0) {
+        size_t n = fread(buf + fill, 1, SCRIPT_BUF_SIZE - fill, in);
+        fill += n;
+        if (n == 0) {
+            if (ferror(in)) {
+                sp -> length = parser.last_end;
+                ret = EOF;
+            } else if (fill > 0) {
+                *(buf + fill++) = '\n';
+                ret = parse_lines(&parser, buf, buf + fill);
+            }
+            break;
+        }
+        // Parse up to the last complete line, and keep the rest for the next block.
+        size_t lines = fill;
+        while (lines > 0 && *(buf + lines - 1) != '\n') {
+            lines--;
+        }
+        if (lines == 0) {
+            if (fill == SCRIPT_BUF_SIZE) {
+                fprintf(stderr, "Malformed event at line %zu\n", parser.line);
+                sp -> length = parser.last_end;
+                ret = EOF;
+            }
+            continue;
+        }
+        ret = parse_lines(&parser, buf, buf + lines);
+        if (func != NULL && ret == 0) {
+            func(arg, sp);
+            sp -> count = 0;
+        }
+        for (size_t i = lines; i < fill; i++) {
+            *(buf + i - lines) = *(buf + i);
+        }
+        fill -= lines;
+    }
+    free(buf);
+    if (func != NULL) {
+        func(arg, sp);
+        sp -> count = 0;
+    }
+    return ret == EOF ? EOF : 0;
+}
+
+int dtmf_script_read(DTMF_SCRIPT *sp, FILE *in, uint32_t length) {
+    return read_script(sp, in, length, NULL, NULL);
+}
+
+int dtmf_script_stream(DTMF_SCRIPT *sp, FILE *in, uint32_t length, DTMF_SCRIPT_FUNC *func,
+                       void *arg) {
+    return read_script(sp, in, length, func, arg);
+}
+
+size_t dtmf_script_find(const DTMF_SCRIPT *sp, uint32_t index) {
+    size_t lo = 0;
+    size_t hi = sp -> count;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if ((sp -> events + mid) -> end <= index) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+void dtmf_script_free(DTMF_SCRIPT *sp) {
+    free(sp -> events);
+    dtmf_script_init(sp);
+}
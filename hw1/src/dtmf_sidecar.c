@@ -0,0 +1,187 @@
+#include <fcntl.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "audio_io.h"
+#include "const.h"
+#include "debug.h"
+#include "dtmf_sidecar.h"
+#include "goertzel_sliding.h"
+#include "tone_family.h"
+
+struct dtmf_sidecar {
+    FILE *out;
+};
+
+DTMF_SIDECAR *dtmf_sidecar_create(const char *path, int block_size, int hop_size,
+                                  uint32_t sample_rate) {
+    DTMF_SIDECAR *sp = malloc(sizeof(DTMF_SIDECAR));
+    if (sp == NULL) {
+        return NULL;
+    }
+    if ((sp -> out = fopen(path, "w")) == NULL) {
+        free(sp);
+        return NULL;
+    }
+    uint32_t header[SIDECAR_HEADER_SIZE / sizeof(uint32_t)] = {
+        SIDECAR_MAGIC, NUM_DTMF_FREQS, block_size, hop_size != 0 ? hop_size : block_size,
+        sample_rate != 0 ? sample_rate : AUDIO_FRAME_RATE, 0
+    };
+    fwrite(header, sizeof(header), 1, sp -> out);
+    return sp;
+}
+
+void dtmf_sidecar_write(DTMF_SIDECAR *sp, const double *strengths) {
+    float record[NUM_DTMF_FREQS];
+    for (int F = 0; F < NUM_DTMF_FREQS; F++) {
+        *(record + F) = *(strengths + F);
+    }
+    fwrite(record, sizeof(record), 1, sp -> out);
+}
+
+int dtmf_sidecar_close(DTMF_SIDECAR *sp) {
+    if (sp == NULL) {
+        return 0;
+    }
+    int ret = ferror(sp -> out) ? EOF : 0;
+    if (fclose(sp -> out) == EOF) {
+        ret = EOF;
+    }
+    free(sp);
+    return ret;
+}
+
+/*
+ * Where the events go, with their indices converted to sample indices of the
+ * input, if that was decimated.
+ */
+typedef struct redecide_output {
+    uint32_t rate;
+    DTMF_EVENT_FUNC *func;
+    void *arg;
+} REDECIDE_OUTPUT;
+
+static int input_index(const REDECIDE_OUTPUT *op, int index) {
+    return ((int64_t)index * op -> rate + AUDIO_FRAME_RATE / 2) / AUDIO_FRAME_RATE;
+}
+
+static void report_event(void *arg, int start, int end, uint8_t symbol) {
+    REDECIDE_OUTPUT *op = arg;
+    op -> func(op -> arg, input_index(op, start), end == -1 ? -1 : input_index(op, end), symbol);
+}
+
+int dtmf_redecide(const char *path, const DTMF_THRESHOLDS *tp, DTMF_EVENT_FUNC *func, void *arg) {
+    int fd = open(path, O_RDONLY);
+    if (fd == -1) {
+        return EOF;
+    }
+    struct stat st;
+    void *map = MAP_FAILED;
+    if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size >= SIDECAR_HEADER_SIZE) {
+        map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    }
+    close(fd);
+    if (map == MAP_FAILED) {
+        return EOF;
+    }
+    const uint32_t *header = map;
+    int N = *(header + 2);
+    int hop = *(header + 3);
+    REDECIDE_OUTPUT out = { .rate = *(header + 4), .func = func, .arg = arg };
+    if (*header != SIDECAR_MAGIC || *(header + 1) != NUM_DTMF_FREQS || N < 10
+        || N > GOERTZEL_SLIDING_MAX_N || hop < 1 || hop > N
+        || out.rate < AUDIO_FRAME_RATE || out.rate > AUDIO_MAX_RATE) {
+        munmap(map, st.st_size);
+        return EOF;
+    }
+    // The records are read where they lie in the mapping, one window at a time.
+    const float *record = (const float *)((const char *)map + SIDECAR_HEADER_SIZE);
+    size_t windows = (st.st_size - SIDECAR_HEADER_SIZE) / (NUM_DTMF_FREQS * sizeof(float));
+    DTMF_TRACKER tracker;
+    dtmf_tracker_init(&tracker, N);
+    tracker.min_duration = tp -> min_duration;
+    tracker.hop = hop;
+    const TONE_FAMILY *fp = tone_family_get(TONE_FAMILY_DTMF);
+    double strengths[NUM_DTMF_FREQS];
+    for (size_t i = 0; i < windows; i++, record += NUM_DTMF_FREQS) {
+        for (int F = 0; F < NUM_DTMF_FREQS; F++) {
+            *(strengths + F) = *(record + F);
+        }
+        uint8_t symbol = dtmf_classify_thresholds(strengths, tp);
+        // Overlapping windows are tracked as the detector tracked them.
+        if (hop < N) {
+            dtmf_tracker_slide(&tracker, i * hop, symbol, tone_family_power(fp, strengths, symbol),
+                               report_event, &out);
+        } else {
+            dtmf_tracker_window(&tracker, i * hop, symbol, report_event, &out);
+        }
+    }
+    dtmf_tracker_finish(&tracker, report_event, &out);
+    munmap(map, st.st_size);
+    return 0;
+}
+
+/*
+ * If the name at *sp is name, followed by '=', advance *sp past the '='.
+ */
+static int match_name(const char **sp, const char *name) {
+    const char *s = *sp;
+    while (*name != '\0' && *s == *name) {
+        s++;
+        name++;
+    }
+    if (*name != '\0' || *s != '=') {
+        return 0;
+    }
+    *sp = s + 1;
+    return 1;
+}
+
+int dtmf_thresholds_parse(const char *spec, DTMF_THRESHOLDS *tp) {
+    static const char *names[] = { "twist", "margin", "floor", "duration" };
+    *tp = dtmf_default_thresholds;
+    int seen = 0;
+    while (1) {
+        int which = 0;
+        while (which < 4 && !match_name(&spec, *(names + which))) {
+            which++;
+        }
+        if (which == 4 || (seen & (1 << which))) {
+            return -1;
+        }
+        seen |= 1 << which;
+        char *end;
+        double value = strtod(spec, &end);
+        if (end == spec || (*end != ',' && *end != '\0') || !isfinite(value)) {
+            return -1;
+        }
+        switch (which) {
+        case 0:
+        case 1:
+            // A twist or margin is a ratio of at least one, either way round.
+            if (value < 0) {
+                return -1;
+            }
+            *(which == 0 ? &tp -> twist : &tp -> margin) = pow(10, value / 10);
+            break;
+        case 2:
+            tp -> floor = pow(10, value / 10);
+            break;
+        case 3:
+            if (value < 0) {
+                return -1;
+            }
+            tp -> min_duration = value / 1000;
+            break;
+        }
+        if (*end == '\0') {
+            return 0;
+        }
+        spec = end + 1;
+    }
+}
@@ -0,0 +1,146 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "audio_io.h"
+#include "const.h"
+#include "debug.h"
+#include "dtmf_sweep.h"
+
+/*
+ * Where the events of one block size go, and what is known of them so far.
+ */
+typedef struct sweep_output {
+    FILE *out;
+    int size;
+    int events;
+    int64_t tone;     // Total duration of the events, in samples of the input.
+    int shortest;     // Duration of the shortest event, or -1 if none.
+    double seconds;   // Time spent in the detector, including printing.
+    double printing;  // Time spent printing events.
+} SWEEP_OUTPUT;
+
+static double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void print_sweep_event(void *arg, int start, int end, uint8_t symbol) {
+    SWEEP_OUTPUT *op = arg;
+    double t0 = now();
+    fprintf(op -> out, "%d\t", op -> size);
+    dtmf_event_print(op -> out, start, end, symbol);
+    op -> printing += now() - t0;
+    if (end == -1) {
+        return;
+    }
+    op -> events++;
+    op -> tone += end - start;
+    if (op -> shortest == -1 || end - start < op -> shortest) {
+        op -> shortest = end - start;
+    }
+}
+
+int dtmf_detect_sweep(FILE *audio_in, const DTMF_DETECTOR_CONFIG *cfg, const char *spec,
+                      FILE *events_out, FILE *stats_out) {
+    int sizes[SWEEP_MAX_SIZES];
+    int count = dtmf_sweep_parse(spec, sizes, SWEEP_MAX_SIZES);
+    if (count == -1) {
+        return EOF;
+    }
+    DTMF_DETECTOR **detectors = calloc(count, sizeof(DTMF_DETECTOR *));
+    SWEEP_OUTPUT *outputs = calloc(count, sizeof(SWEEP_OUTPUT));
+    int ret = detectors != NULL && outputs != NULL ? 0 : EOF;
+    for (int i = 0; i < count && ret == 0; i++) {
+        DTMF_DETECTOR_CONFIG fc = *cfg;
+        fc.block_size = *(sizes + i);
+        *(outputs + i) = (SWEEP_OUTPUT){ .out = events_out, .size = *(sizes + i), .shortest = -1 };
+        if ((*(detectors + i) = dtmf_detector_new(&fc)) == NULL) {
+            ret = EOF;
+        }
+    }
+    if (ret == 0) {
+        int16_t samples[SAMPLE_BUF_SIZE];
+        size_t got;
+        while ((got = audio_read_encoded(audio_in, cfg -> encoding, samples, SAMPLE_BUF_SIZE)) > 0) {
+            for (int i = 0; i < count; i++) {
+                SWEEP_OUTPUT *op = outputs + i;
+                double t0 = now();
+                dtmf_detector_feed(*(detectors + i), samples, got, print_sweep_event, op);
+                op -> seconds += now() - t0;
+            }
+        }
+        double rate = cfg -> sample_rate != 0 ? cfg -> sample_rate : AUDIO_FRAME_RATE;
+        fprintf(stats_out, "size\tevents\ttone_ms\tshortest_ms\tfilter_ms\n");
+        for (int i = 0; i < count; i++) {
+            SWEEP_OUTPUT *op = outputs + i;
+            double t0 = now();
+            dtmf_detector_finish(*(detectors + i), print_sweep_event, op);
+            op -> seconds += now() - t0;
+            fprintf(stats_out, "%d\t%d\t%.1f\t%.1f\t%.1f\n", op -> size, op -> events,
+                    op -> tone * 1000 / rate, op -> shortest == -1 ? 0 : op -> shortest * 1000 / rate,
+                    (op -> seconds - op -> printing) * 1000);
+        }
+    }
+    for (int i = 0; detectors != NULL && i < count; i++) {
+        dtmf_detector_free(*(detectors + i));
+    }
+    free(detectors);
+    free(outputs);
+    return ret;
+}
+
+/*
+ * Parse a decimal number at *sp, advancing *sp past it.
+ *
+ *   @return  The number, or -1 if there is none or it exceeds 9999.
+ */
+static int parse_number(const char **sp) {
+    const char *s = *sp;
+    int n = 0;
+    while (*s >= '0' && *s <= '9' && n <= 9999) {
+        n = 10 * n + (*s++ - '0');
+    }
+    if (s == *sp || n > 9999) {
+        return -1;
+    }
+    *sp = s;
+    return n;
+}
+
+int dtmf_sweep_parse(const char *spec, int *sizes, int max) {
+    char seen[1001] = { 0 };
+    int count = 0;
+    while (1) {
+        int low = parse_number(&spec);
+        int high = low;
+        int step = 1;
+        if (*spec == '-') {
+            spec++;
+            high = parse_number(&spec);
+            if (*spec == ':') {
+                spec++;
+                step = parse_number(&spec);
+            }
+        }
+        if (low < 10 || high > 1000 || high < low || step < 1 || (*spec != ',' && *spec != '\0')) {
+            return -1;
+        }
+        for (int size = low; size <= high; size += step) {
+            if (*(seen + size) || count == max) {
+                return -1;
+            }
+            *(seen + size) = 1;
+            if (sizes != NULL) {
+                *(sizes + count) = size;
+            }
+            count++;
+        }
+        if (*spec == '\0') {
+            return count;
+        }
+        spec++;
+    }
+}
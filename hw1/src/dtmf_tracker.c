@@ -0,0 +1,188 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <time.h>
+
+#include "const.h"
+#include "debug.h"
+#include "dtmf_tracker.h"
+
+/*
+ * Seconds elapsed on the monotonic clock since the specified starting time.
+ */
+static double elapsed_since(struct timespec *t0) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec - t0 -> tv_sec) + (now.tv_nsec - t0 -> tv_nsec) / 1e9;
+}
+
+void dtmf_tracker_init(DTMF_TRACKER *tp, int window) {
+    tp -> window = window;
+    tp -> start = -1;
+    tp -> last = -1;
+    tp -> hop = window;
+    tp -> first_power = 0;
+    tp -> last_power = 0;
+    tp -> peak = 0;
+    tp -> floor = 0;
+    tp -> tone = 0;
+    tp -> flags = 0;
+    tp -> announced = 0;
+    tp -> min_duration = MIN_DTMF_DURATION;
+    tp -> rate = AUDIO_FRAME_RATE;
+}
+
+void dtmf_tracker_stream(DTMF_TRACKER *tp, int flags) {
+    tp -> flags = flags;
+    clock_gettime(CLOCK_MONOTONIC, &tp -> t0);
+}
+
+/*
+ * In streaming mode, report on stderr how far the detection point (the sample
+ * whose arrival allowed an event to be reported) lags behind the wall clock.
+ */
+static void tracker_latency(DTMF_TRACKER *tp, int start, int end, int detected) {
+    if (!(tp -> flags & DTMF_TRACKER_STREAM)) {
+        return;
+    }
+    double latency = elapsed_since(&tp -> t0) - (double)detected / AUDIO_FRAME_RATE;
+    start = ((int64_t)start * tp -> rate + AUDIO_FRAME_RATE / 2) / AUDIO_FRAME_RATE;
+    if (end < 0) {
+        fprintf(stderr, "%i\t-\t%c\tlatency %.1f ms\n", start, tp -> tone, latency * 1000);
+    } else {
+        end = ((int64_t)end * tp -> rate + AUDIO_FRAME_RATE / 2) / AUDIO_FRAME_RATE;
+        fprintf(stderr, "%i\t%i\t%c\tlatency %.1f ms\n", start, end, tp -> tone, latency * 1000);
+    }
+}
+
+/*
+ * For overlapping windows, the part of a window with the specified power that the
+ * current tone fills.
+ */
+static double slide_fill(const DTMF_TRACKER *tp, double power) {
+    return tp -> peak > 0 ? sqrt(power / tp -> peak) : 1;
+}
+
+static int round_hop(const DTMF_TRACKER *tp, int index) {
+    return (index + tp -> hop / 2) / tp -> hop * tp -> hop;
+}
+
+/*
+ * The start index of the current event.  For overlapping windows, that is where
+ * the tone begins in its first window, and tp -> start is the index of that window.
+ */
+static int event_start(const DTMF_TRACKER *tp) {
+    if (tp -> hop >= tp -> window) {
+        return tp -> start;
+    }
+    int start = round_hop(tp, tp -> start + (int)lround(tp -> window
+                                                        * (1 - slide_fill(tp, tp -> first_power))));
+    return start < tp -> floor ? tp -> floor : start;
+}
+
+/*
+ * The end index of the current event, if it ends with the last window in which its
+ * tone was present.  For overlapping windows, that is where the tone ends in that window.
+ */
+static int event_end(const DTMF_TRACKER *tp) {
+    if (tp -> hop >= tp -> window) {
+        return tp -> last + tp -> window;
+    }
+    int start = event_start(tp);
+    int end = round_hop(tp, tp -> last + (int)lround(tp -> window * slide_fill(tp, tp -> last_power)));
+    return end < start ? start : end;
+}
+
+/*
+ * Close the current event at the specified end index, emitting it if it is
+ * long enough.
+ */
+static void tracker_close(DTMF_TRACKER *tp, int end, int detected, DTMF_EVENT_FUNC *func, void *arg) {
+    int start = event_start(tp);
+    if ((double)(end - start) / AUDIO_FRAME_RATE >= tp -> min_duration) {
+        func(arg, start, end, tp -> tone);
+        tracker_latency(tp, start, end, detected);
+        tp -> floor = end;
+    }
+    tp -> start = -1;
+    tp -> tone = 0;
+    tp -> announced = 0;
+}
+
+/*
+ * Announce the onset of the current event, once it has lasted long enough
+ * that it is certain to be emitted.
+ */
+static void tracker_onset(DTMF_TRACKER *tp, DTMF_EVENT_FUNC *func, void *arg) {
+    if (!(tp -> flags & DTMF_TRACKER_ONSET) || tp -> announced) {
+        return;
+    }
+    int start = event_start(tp);
+    if ((double)(event_end(tp) - start) / AUDIO_FRAME_RATE < tp -> min_duration) {
+        return;
+    }
+    func(arg, start, -1, tp -> tone);
+    tracker_latency(tp, start, -1, tp -> last + tp -> window);
+    tp -> announced = 1;
+}
+
+void dtmf_tracker_window(DTMF_TRACKER *tp, int index, uint8_t symbol, DTMF_EVENT_FUNC *func, void *arg) {
+    if (tp -> start != -1 && symbol == tp -> tone) {
+        tp -> last = index;
+        tracker_onset(tp, func, arg);
+        return;
+    }
+    if (tp -> start != -1) {
+        int end = tp -> last + tp -> window;
+        if (symbol != 0 && index < end) {
+            end = index;
+        }
+        tracker_close(tp, end, index + tp -> window, func, arg);
+    }
+    if (symbol != 0) {
+        tp -> start = index < tp -> floor ? tp -> floor : index;
+        tp -> last = index;
+        tp -> tone = symbol;
+        tracker_onset(tp, func, arg);
+    }
+}
+
+void dtmf_tracker_slide(DTMF_TRACKER *tp, int index, uint8_t symbol, double power,
+                        DTMF_EVENT_FUNC *func, void *arg) {
+    if (tp -> start != -1 && symbol == tp -> tone) {
+        tp -> last = index;
+        tp -> last_power = power;
+        if (power > tp -> peak) {
+            tp -> peak = power;
+        }
+        tracker_onset(tp, func, arg);
+        return;
+    }
+    if (tp -> start != -1) {
+        tracker_close(tp, event_end(tp), index + tp -> window, func, arg);
+    }
+    if (symbol != 0) {
+        tp -> start = index;
+        tp -> last = index;
+        tp -> first_power = power;
+        tp -> last_power = power;
+        tp -> peak = power;
+        tp -> tone = symbol;
+        tracker_onset(tp, func, arg);
+    }
+}
+
+void dtmf_tracker_finish(DTMF_TRACKER *tp, DTMF_EVENT_FUNC *func, void *arg) {
+    if (tp -> start != -1) {
+        tracker_close(tp, event_end(tp), tp -> last + tp -> window, func, arg);
+    }
+}
+
+void dtmf_event_print(void *arg, int start, int end, uint8_t symbol) {
+    FILE *out = arg;
+    if (end < 0) {
+        fprintf(out, "%i\t-\t%c\n", start, symbol);
+    } else {
+        fprintf(out, "%i\t%i\t%c\n", start, end, symbol);
+    }
+}
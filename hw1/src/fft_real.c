@@ -0,0 +1,150 @@
+#include <math.h>
+#include <stdint.h>
+
+#include "debug.h"
+#include "fft_real.h"
+
+/*
+ * Twiddle factors: fft_cos[j] + i fft_sin[j] = exp(-2 pi i j / FFT_MAX_SIZE).
+ * Those of a transform of size M are every (FFT_MAX_SIZE / M)-th entry.
+ */
+static double fft_cos[FFT_MAX_SIZE];
+static double fft_sin[FFT_MAX_SIZE];
+
+__attribute__((constructor))
+static void fft_init_twiddles(void) {
+    for (int j = 0; j < FFT_MAX_SIZE; j++) {
+        *(fft_cos + j) = cos(2 * M_PI * j / FFT_MAX_SIZE);
+        *(fft_sin + j) = -sin(2 * M_PI * j / FFT_MAX_SIZE);
+    }
+}
+
+int fft_size(int N) {
+    int M = 2;
+    while (M < FFT_PADDING * N) {
+        M *= 2;
+    }
+    return M;
+}
+
+/*
+ * In-place iterative radix-2 complex FFT of size H, a power of two.
+ */
+static void fft_complex(double *re, double *im, int H) {
+    for (int i = 1, j = 0; i < H; i++) {
+        int bit = H >> 1;
+        for (; j & bit; bit >>= 1) {
+            j ^= bit;
+        }
+        j |= bit;
+        if (i < j) {
+            double t = *(re + i); *(re + i) = *(re + j); *(re + j) = t;
+            t = *(im + i); *(im + i) = *(im + j); *(im + j) = t;
+        }
+    }
+    for (int len = 2; len <= H; len *= 2) {
+        int half = len / 2;
+        int stride = FFT_MAX_SIZE / len;
+        for (int i = 0; i < H; i += len) {
+            for (int j = 0; j < half; j++) {
+                double wr = *(fft_cos + j * stride);
+                double wi = *(fft_sin + j * stride);
+                double *ar = re + i + j, *ai = im + i + j;
+                double *br = ar + half, *bi = ai + half;
+                double vr = *br * wr - *bi * wi;
+                double vi = *br * wi + *bi * wr;
+                *br = *ar - vr;
+                *bi = *ai - vi;
+                *ar += vr;
+                *ai += vi;
+            }
+        }
+    }
+}
+
+/*
+ * Transform a real block of M values, of which the first N are y and the rest zero,
+ * into re and im: its M/2 even values are packed into the real parts and its odd
+ * values into the imaginary parts of a complex transform of size M/2.
+ */
+static void fft_packed(const double *y, int N, double *re, double *im, int H) {
+    for (int n = 0; n < H; n++) {
+        *(re + n) = 2 * n < N ? *(y + 2 * n) : 0;
+        *(im + n) = 2 * n + 1 < N ? *(y + 2 * n + 1) : 0;
+    }
+    fft_complex(re, im, H);
+}
+
+/*
+ * Unpack bin j of the real transform of size M from the packed transform in re and
+ * im: separate the transforms of the even and odd values, E and O, from
+ * Z[j] = E[j] + i O[j] and conj(Z[H - j]) = E[j] - i O[j], then
+ * X[j] = E[j] + exp(-2 pi i j / M) O[j].
+ */
+static void fft_bin(const double *re, const double *im, int M, int j, double *xr, double *xi) {
+    int H = M / 2;
+    int c = (H - j) % H;
+    double zr = *(re + j), zi = *(im + j);
+    double cr = *(re + c), ci = -*(im + c);
+    double er = (zr + cr) / 2, ei = (zi + ci) / 2;
+    double odr = (zi - ci) / 2, odi = (cr - zr) / 2;
+    double wr = *(fft_cos + j * (FFT_MAX_SIZE / M));
+    double wi = *(fft_sin + j * (FFT_MAX_SIZE / M));
+    *xr = er + odr * wr - odi * wi;
+    *xi = ei + odr * wi + odi * wr;
+}
+
+void fft_strengths(const GOERTZEL_PLAN *plans, int count, const int16_t *samples,
+                   double *strengths) {
+    int N = plans -> N;
+    int M = fft_size(N);
+    int H = M / 2;
+    double re[FFT_MAX_SIZE / 2];
+    double im[FFT_MAX_SIZE / 2];
+    double y[FFT_MAX_SIZE / FFT_PADDING];
+    // Component k lies phi = 2 pi (k / N - j / M) from its nearest bin j.  With
+    // u = (n - c) / (N / 2) about the middle c = (N - 1) / 2 of the block,
+    // exp(-i phi n) = exp(-i phi c) sum_m (-i phi N / 2)^m u^m / m!, so X(k) is, up to
+    // a factor exp(-i phi c) that leaves its strength unchanged, the sum over m of
+    // (-i phi N / 2)^m / m! times bin j of the transform of the samples times u^m.
+    int bins[count];
+    double zs[count], sum_r[count], sum_i[count], coef_r[count], coef_i[count];
+    for (int F = 0; F < count; F++) {
+        const GOERTZEL_PLAN *pp = plans + F;
+        int j = (int)lround(pp -> k * M / N);
+        if (j >= H) {
+            j = H - 1;
+        }
+        *(bins + F) = j;
+        *(zs + F) = -M_PI * (pp -> k - (double)j * N / M);
+        *(sum_r + F) = *(sum_i + F) = 0;
+        *(coef_r + F) = 1;
+        *(coef_i + F) = 0;
+    }
+    for (int n = 0; n < N; n++) {
+        *(y + n) = (double)*(samples + n) / INT16_MAX;
+    }
+    for (int m = 0; m < FFT_TERMS; m++) {
+        if (m > 0) {
+            for (int n = 0; n < N; n++) {
+                *(y + n) *= (2.0 * n - (N - 1)) / N;
+            }
+        }
+        fft_packed(y, N, re, im, H);
+        for (int F = 0; F < count; F++) {
+            double xr, xi;
+            fft_bin(re, im, M, *(bins + F), &xr, &xi);
+            double cr = *(coef_r + F), ci = *(coef_i + F);
+            *(sum_r + F) += cr * xr - ci * xi;
+            *(sum_i + F) += cr * xi + ci * xr;
+            // Multiply the coefficient by -i phi N / 2 = i zs, and divide by m + 1.
+            double z = *(zs + F) / (m + 1);
+            *(coef_r + F) = -ci * z;
+            *(coef_i + F) = cr * z;
+        }
+    }
+    for (int F = 0; F < count; F++) {
+        double sr = *(sum_r + F), si = *(sum_i + F);
+        *(strengths + F) = 2 * (sr * sr + si * si) * ((plans + F) -> inv_N2);
+    }
+}
@@ -0,0 +1,126 @@
+#include <stdint.h>
+
+#include "debug.h"
+#include "goertzel_bank.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define GOERTZEL_BANK_X86
+#endif
+
+void goertzel_bank_load(GOERTZEL_BANK *bp, const GOERTZEL_STATE *states) {
+    bp -> N = states -> N;
+    for (int i = 0; i < GOERTZEL_BANK_SIZE; i++) {
+        const GOERTZEL_STATE *gp = states + i;
+        *(bp -> k + i) = gp -> k;
+        *(bp -> A + i) = gp -> A;
+        *(bp -> B + i) = gp -> B;
+        *(bp -> s1 + i) = gp -> s1;
+        *(bp -> s2 + i) = gp -> s2;
+    }
+}
+
+void goertzel_bank_step(GOERTZEL_BANK *bp, double x) {
+    for (int i = 0; i < GOERTZEL_BANK_SIZE; i++) {
+        double s0 = x + *(bp -> B + i) * *(bp -> s1 + i) - *(bp -> s2 + i);
+        *(bp -> s2 + i) = *(bp -> s1 + i);
+        *(bp -> s1 + i) = s0;
+    }
+}
+
+static void bank_run_scalar(GOERTZEL_BANK *bp, const int16_t *samples, size_t n) {
+    for (size_t j = 0; j < n; j++) {
+        goertzel_bank_step(bp, (double)*(samples + j) / INT16_MAX);
+    }
+}
+
+#ifdef GOERTZEL_BANK_X86
+/*
+ * The vector versions evaluate x + B * s1 - s2 in the same order as the scalar
+ * version, and neither is compiled with FMA enabled, so they produce bit-for-bit
+ * the same state.
+ */
+__attribute__((target("avx")))
+static void bank_run_avx(GOERTZEL_BANK *bp, const int16_t *samples, size_t n) {
+    __m256d B_lo = _mm256_load_pd(bp -> B);
+    __m256d B_hi = _mm256_load_pd(bp -> B + 4);
+    __m256d s1_lo = _mm256_load_pd(bp -> s1);
+    __m256d s1_hi = _mm256_load_pd(bp -> s1 + 4);
+    __m256d s2_lo = _mm256_load_pd(bp -> s2);
+    __m256d s2_hi = _mm256_load_pd(bp -> s2 + 4);
+    for (size_t j = 0; j < n; j++) {
+        __m256d x = _mm256_set1_pd((double)*(samples + j) / INT16_MAX);
+        __m256d s0_lo = _mm256_sub_pd(_mm256_add_pd(x, _mm256_mul_pd(B_lo, s1_lo)), s2_lo);
+        __m256d s0_hi = _mm256_sub_pd(_mm256_add_pd(x, _mm256_mul_pd(B_hi, s1_hi)), s2_hi);
+        s2_lo = s1_lo;
+        s2_hi = s1_hi;
+        s1_lo = s0_lo;
+        s1_hi = s0_hi;
+    }
+    _mm256_store_pd(bp -> s1, s1_lo);
+    _mm256_store_pd(bp -> s1 + 4, s1_hi);
+    _mm256_store_pd(bp -> s2, s2_lo);
+    _mm256_store_pd(bp -> s2 + 4, s2_hi);
+}
+
+__attribute__((target("sse2")))
+static void bank_run_sse2(GOERTZEL_BANK *bp, const int16_t *samples, size_t n) {
+    __m128d B0 = _mm_load_pd(bp -> B), B1 = _mm_load_pd(bp -> B + 2);
+    __m128d B2 = _mm_load_pd(bp -> B + 4), B3 = _mm_load_pd(bp -> B + 6);
+    __m128d a0 = _mm_load_pd(bp -> s1), a1 = _mm_load_pd(bp -> s1 + 2);
+    __m128d a2 = _mm_load_pd(bp -> s1 + 4), a3 = _mm_load_pd(bp -> s1 + 6);
+    __m128d b0 = _mm_load_pd(bp -> s2), b1 = _mm_load_pd(bp -> s2 + 2);
+    __m128d b2 = _mm_load_pd(bp -> s2 + 4), b3 = _mm_load_pd(bp -> s2 + 6);
+    for (size_t j = 0; j < n; j++) {
+        __m128d x = _mm_set1_pd((double)*(samples + j) / INT16_MAX);
+        __m128d c0 = _mm_sub_pd(_mm_add_pd(x, _mm_mul_pd(B0, a0)), b0);
+        __m128d c1 = _mm_sub_pd(_mm_add_pd(x, _mm_mul_pd(B1, a1)), b1);
+        __m128d c2 = _mm_sub_pd(_mm_add_pd(x, _mm_mul_pd(B2, a2)), b2);
+        __m128d c3 = _mm_sub_pd(_mm_add_pd(x, _mm_mul_pd(B3, a3)), b3);
+        b0 = a0; b1 = a1; b2 = a2; b3 = a3;
+        a0 = c0; a1 = c1; a2 = c2; a3 = c3;
+    }
+    _mm_store_pd(bp -> s1, a0); _mm_store_pd(bp -> s1 + 2, a1);
+    _mm_store_pd(bp -> s1 + 4, a2); _mm_store_pd(bp -> s1 + 6, a3);
+    _mm_store_pd(bp -> s2, b0); _mm_store_pd(bp -> s2 + 2, b1);
+    _mm_store_pd(bp -> s2 + 4, b2); _mm_store_pd(bp -> s2 + 6, b3);
+}
+#endif
+
+/*
+ * Implementation of goertzel_bank_run, chosen once according to the
+ * capabilities of the CPU.
+ */
+static void (*bank_run_impl)(GOERTZEL_BANK *, const int16_t *, size_t);
+
+__attribute__((constructor))
+static void bank_select_impl(void) {
+    bank_run_impl = bank_run_scalar;
+#ifdef GOERTZEL_BANK_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx")) {
+        bank_run_impl = bank_run_avx;
+    } else if (__builtin_cpu_supports("sse2")) {
+        bank_run_impl = bank_run_sse2;
+    }
+    debug("goertzel bank: %s", bank_run_impl == bank_run_avx ? "avx" :
+          bank_run_impl == bank_run_sse2 ? "sse2" : "scalar");
+#endif
+}
+
+void goertzel_bank_run(GOERTZEL_BANK *bp, const int16_t *samples, size_t n) {
+    (*bank_run_impl)(bp, samples, n);
+}
+
+void goertzel_bank_store(GOERTZEL_BANK *bp, GOERTZEL_STATE *states) {
+    for (int i = 0; i < GOERTZEL_BANK_SIZE; i++) {
+        GOERTZEL_STATE *gp = states + i;
+        gp -> N = bp -> N;
+        gp -> k = *(bp -> k + i);
+        gp -> A = *(bp -> A + i);
+        gp -> B = *(bp -> B + i);
+        gp -> s0 = *(bp -> s1 + i);
+        gp -> s1 = *(bp -> s1 + i);
+        gp -> s2 = *(bp -> s2 + i);
+    }
+}
@@ -0,0 +1,133 @@
+#include <stdint.h>
+#include <math.h>
+
+#include "debug.h"
+#include "goertzel_fixed.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define GOERTZEL_QBANK_X86
+#endif
+
+#define Q_ROUND ((int64_t)1 << (GOERTZEL_Q_SHIFT - 1))
+
+void goertzel_qbank_load(GOERTZEL_QBANK *qp, const GOERTZEL_STATE *states) {
+    qp -> N = states -> N;
+    for (int i = 0; i < GOERTZEL_BANK_SIZE; i++) {
+        const GOERTZEL_STATE *gp = states + i;
+        *(qp -> B + i) = llround(ldexp(gp -> B, GOERTZEL_Q_SHIFT));
+        *(qp -> s1 + i) = llround(gp -> s1 * INT16_MAX);
+        *(qp -> s2 + i) = llround(gp -> s2 * INT16_MAX);
+    }
+}
+
+/*
+ * Only the low 32 bits of each state variable are significant.  All the vector
+ * versions compute exactly those bits, so every version gives the same result.
+ */
+static void qbank_run_scalar(GOERTZEL_QBANK *qp, const int16_t *samples, size_t n) {
+    for (size_t j = 0; j < n; j++) {
+        int32_t x = *(samples + j);
+        for (int i = 0; i < GOERTZEL_BANK_SIZE; i++) {
+            int32_t s1 = (int32_t)*(qp -> s1 + i);
+            int32_t s2 = (int32_t)*(qp -> s2 + i);
+            int64_t p = (int64_t)(int32_t)*(qp -> B + i) * s1 + Q_ROUND;
+            *(qp -> s2 + i) = s1;
+            *(qp -> s1 + i) = (int32_t)(x + (p >> GOERTZEL_Q_SHIFT) - s2);
+        }
+    }
+}
+
+#ifdef GOERTZEL_QBANK_X86
+/*
+ * There is no 64-bit arithmetic right shift before AVX-512, but a logical shift
+ * leaves the same low 32 bits, which are the only ones that matter.
+ */
+__attribute__((target("avx2")))
+static void qbank_run_avx2(GOERTZEL_QBANK *qp, const int16_t *samples, size_t n) {
+    __m256i round = _mm256_set1_epi64x(Q_ROUND);
+    __m256i B_lo = _mm256_load_si256((__m256i *)qp -> B);
+    __m256i B_hi = _mm256_load_si256((__m256i *)(qp -> B + 4));
+    __m256i s1_lo = _mm256_load_si256((__m256i *)qp -> s1);
+    __m256i s1_hi = _mm256_load_si256((__m256i *)(qp -> s1 + 4));
+    __m256i s2_lo = _mm256_load_si256((__m256i *)qp -> s2);
+    __m256i s2_hi = _mm256_load_si256((__m256i *)(qp -> s2 + 4));
+    for (size_t j = 0; j < n; j++) {
+        __m256i x = _mm256_set1_epi64x(*(samples + j));
+        __m256i p_lo = _mm256_add_epi64(_mm256_mul_epi32(B_lo, s1_lo), round);
+        __m256i p_hi = _mm256_add_epi64(_mm256_mul_epi32(B_hi, s1_hi), round);
+        p_lo = _mm256_srli_epi64(p_lo, GOERTZEL_Q_SHIFT);
+        p_hi = _mm256_srli_epi64(p_hi, GOERTZEL_Q_SHIFT);
+        __m256i s0_lo = _mm256_sub_epi32(_mm256_add_epi32(x, p_lo), s2_lo);
+        __m256i s0_hi = _mm256_sub_epi32(_mm256_add_epi32(x, p_hi), s2_hi);
+        s2_lo = s1_lo;
+        s2_hi = s1_hi;
+        s1_lo = s0_lo;
+        s1_hi = s0_hi;
+    }
+    _mm256_store_si256((__m256i *)qp -> s1, s1_lo);
+    _mm256_store_si256((__m256i *)(qp -> s1 + 4), s1_hi);
+    _mm256_store_si256((__m256i *)qp -> s2, s2_lo);
+    _mm256_store_si256((__m256i *)(qp -> s2 + 4), s2_hi);
+}
+
+__attribute__((target("sse4.1")))
+static void qbank_run_sse41(GOERTZEL_QBANK *qp, const int16_t *samples, size_t n) {
+    __m128i round = _mm_set1_epi64x(Q_ROUND);
+    for (int i = 0; i < GOERTZEL_BANK_SIZE; i += 4) {
+        __m128i B0 = _mm_load_si128((__m128i *)(qp -> B + i));
+        __m128i B1 = _mm_load_si128((__m128i *)(qp -> B + i + 2));
+        __m128i a0 = _mm_load_si128((__m128i *)(qp -> s1 + i));
+        __m128i a1 = _mm_load_si128((__m128i *)(qp -> s1 + i + 2));
+        __m128i b0 = _mm_load_si128((__m128i *)(qp -> s2 + i));
+        __m128i b1 = _mm_load_si128((__m128i *)(qp -> s2 + i + 2));
+        for (size_t j = 0; j < n; j++) {
+            __m128i x = _mm_set1_epi64x(*(samples + j));
+            __m128i p0 = _mm_srli_epi64(_mm_add_epi64(_mm_mul_epi32(B0, a0), round), GOERTZEL_Q_SHIFT);
+            __m128i p1 = _mm_srli_epi64(_mm_add_epi64(_mm_mul_epi32(B1, a1), round), GOERTZEL_Q_SHIFT);
+            __m128i c0 = _mm_sub_epi32(_mm_add_epi32(x, p0), b0);
+            __m128i c1 = _mm_sub_epi32(_mm_add_epi32(x, p1), b1);
+            b0 = a0; b1 = a1;
+            a0 = c0; a1 = c1;
+        }
+        _mm_store_si128((__m128i *)(qp -> s1 + i), a0);
+        _mm_store_si128((__m128i *)(qp -> s1 + i + 2), a1);
+        _mm_store_si128((__m128i *)(qp -> s2 + i), b0);
+        _mm_store_si128((__m128i *)(qp -> s2 + i + 2), b1);
+    }
+}
+#endif
+
+/*
+ * Implementation of goertzel_qbank_run, chosen once according to the
+ * capabilities of the CPU.
+ */
+static void (*qbank_run_impl)(GOERTZEL_QBANK *, const int16_t *, size_t);
+
+__attribute__((constructor))
+static void qbank_select_impl(void) {
+    qbank_run_impl = qbank_run_scalar;
+#ifdef GOERTZEL_QBANK_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        qbank_run_impl = qbank_run_avx2;
+    } else if (__builtin_cpu_supports("sse4.1")) {
+        qbank_run_impl = qbank_run_sse41;
+    }
+    debug("goertzel qbank: %s", qbank_run_impl == qbank_run_avx2 ? "avx2" :
+          qbank_run_impl == qbank_run_sse41 ? "sse4.1" : "scalar");
+#endif
+}
+
+void goertzel_qbank_run(GOERTZEL_QBANK *qp, const int16_t *samples, size_t n) {
+    (*qbank_run_impl)(qp, samples, n);
+}
+
+void goertzel_qbank_store(GOERTZEL_QBANK *qp, GOERTZEL_STATE *states) {
+    for (int i = 0; i < GOERTZEL_BANK_SIZE; i++) {
+        GOERTZEL_STATE *gp = states + i;
+        gp -> s1 = (double)(int32_t)*(qp -> s1 + i) / INT16_MAX;
+        gp -> s2 = (double)(int32_t)*(qp -> s2 + i) / INT16_MAX;
+        gp -> s0 = gp -> s1;
+    }
+}
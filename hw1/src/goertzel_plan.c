@@ -0,0 +1,35 @@
+#include <stdint.h>
+#include <math.h>
+
+#include "debug.h"
+#include "goertzel_plan.h"
+
+void goertzel_plan_init(GOERTZEL_PLAN *pp, uint32_t N, double k) {
+    pp -> N = N;
+    pp -> k = k;
+    pp -> A = 2 * M_PI * k / N;
+    pp -> B = 2 * cos(pp -> A);
+    double G = (pp -> A) * (N - 1);
+    pp -> cos_G = cos(G);
+    pp -> cos_AG = cos((pp -> A) + G);
+    pp -> sin_G = sin(G);
+    pp -> sin_AG = sin((pp -> A) + G);
+    pp -> inv_N2 = 1.0 / ((double)N * N);
+}
+
+void goertzel_plan_start(const GOERTZEL_PLAN *pp, GOERTZEL_STATE *gp) {
+    gp -> N = pp -> N;
+    gp -> k = pp -> k;
+    gp -> A = pp -> A;
+    gp -> B = pp -> B;
+    gp -> s0 = 0;
+    gp -> s1 = 0;
+    gp -> s2 = 0;
+}
+
+double goertzel_plan_strength(const GOERTZEL_PLAN *pp, GOERTZEL_STATE *gp, double x) {
+    gp -> s0 = x + (gp -> B) * (gp -> s1) - (gp -> s2);
+    double re = (gp -> s0) * (pp -> cos_G) - (gp -> s1) * (pp -> cos_AG);
+    double im = (gp -> s1) * (pp -> sin_AG) - (gp -> s0) * (pp -> sin_G);
+    return 2 * (re * re + im * im) * (pp -> inv_N2);
+}
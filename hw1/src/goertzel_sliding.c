@@ -0,0 +1,81 @@
+#include <stdint.h>
+#include <math.h>
+
+#include "debug.h"
+#include "goertzel_sliding.h"
+
+/*
+ * Recompute the transforms directly from the samples in the window.
+ * The oldest sample is at pos, and is multiplied by e^{-jA*0}.
+ */
+static void sliding_resync(GOERTZEL_SLIDING *sp) {
+    for (int i = 0; i < GOERTZEL_BANK_SIZE; i++) {
+        double re = 0;
+        double im = 0;
+        // Accumulate x(m) * e^{-jAm} by rotating a phasor through the window.
+        double c = 1;
+        double s = 0;
+        double rc = *(sp -> rot_re + i);
+        double rs = -*(sp -> rot_im + i);
+        for (uint32_t m = 0; m < sp -> N; m++) {
+            double x = *(sp -> window + (sp -> pos + m) % sp -> N);
+            re += x * c;
+            im += x * s;
+            double t = c * rc - s * rs;
+            s = c * rs + s * rc;
+            c = t;
+        }
+        *(sp -> re + i) = re;
+        *(sp -> im + i) = im;
+    }
+    sp -> passes = 0;
+}
+
+void goertzel_sliding_init(GOERTZEL_SLIDING *sp, const GOERTZEL_PLAN *plans) {
+    sp -> N = plans -> N;
+    sp -> pos = 0;
+    sp -> passes = 0;
+    for (int i = 0; i < GOERTZEL_BANK_SIZE; i++) {
+        const GOERTZEL_PLAN *pp = plans + i;
+        *(sp -> re + i) = 0;
+        *(sp -> im + i) = 0;
+        *(sp -> rot_re + i) = cos(pp -> A);
+        *(sp -> rot_im + i) = sin(pp -> A);
+        *(sp -> in_re + i) = cos((pp -> A) * (pp -> N - 1));
+        *(sp -> in_im + i) = -sin((pp -> A) * (pp -> N - 1));
+        *(sp -> inv_N2 + i) = pp -> inv_N2;
+    }
+    for (uint32_t m = 0; m < sp -> N; m++) {
+        *(sp -> window + m) = 0;
+    }
+}
+
+void goertzel_sliding_run(GOERTZEL_SLIDING *sp, const int16_t *samples, size_t n) {
+    for (size_t j = 0; j < n; j++) {
+        double x = (double)*(samples + j) / INT16_MAX;
+        double old = *(sp -> window + sp -> pos);
+        *(sp -> window + sp -> pos) = x;
+        for (int i = 0; i < GOERTZEL_BANK_SIZE; i++) {
+            double re = *(sp -> re + i) - old;
+            double im = *(sp -> im + i);
+            *(sp -> re + i) = re * *(sp -> rot_re + i) - im * *(sp -> rot_im + i)
+                              + x * *(sp -> in_re + i);
+            *(sp -> im + i) = re * *(sp -> rot_im + i) + im * *(sp -> rot_re + i)
+                              + x * *(sp -> in_im + i);
+        }
+        if (++(sp -> pos) == sp -> N) {
+            sp -> pos = 0;
+            if (++(sp -> passes) == GOERTZEL_SLIDING_RESYNC) {
+                sliding_resync(sp);
+            }
+        }
+    }
+}
+
+void goertzel_sliding_strengths(GOERTZEL_SLIDING *sp, double *strengths) {
+    for (int i = 0; i < GOERTZEL_BANK_SIZE; i++) {
+        double re = *(sp -> re + i);
+        double im = *(sp -> im + i);
+        *(strengths + i) = 2 * (re * re + im * im) * *(sp -> inv_N2 + i);
+    }
+}
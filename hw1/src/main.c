@@ -3,6 +3,7 @@
 
 #include "const.h"
 #include "debug.h"
+#include "dtmf_options.h"
 
 #ifdef _STRING_H
 #error "Do not #include <string.h>. You will get a ZERO."
@@ -19,10 +20,10 @@
 int main(int argc, char **argv)
 {
 	if (validargs(argc, argv)) {
-		USAGE(*argv, EXIT_FAILURE);
+		DTMF_USAGE(*argv, EXIT_FAILURE);
 	}
 	if (global_options & 1) {
-		USAGE(*argv, EXIT_SUCCESS);
+		DTMF_USAGE(*argv, EXIT_SUCCESS);
 	}
 	if ((global_options & 2) >> 1) { // generate
     	if (dtmf_generate(stdin, stdout, audio_samples) != EOF) {
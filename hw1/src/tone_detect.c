@@ -0,0 +1,64 @@
+#include <stdio.h>
+#include <stdint.h>
+
+#include "audio_io.h"
+#include "const.h"
+#include "debug.h"
+#include "tone_detect.h"
+
+/*
+ * Where the events of one family go.
+ */
+typedef struct family_output {
+    FILE *out;
+    const char *name;
+} FAMILY_OUTPUT;
+
+static void print_family_event(void *arg, int start, int end, uint8_t symbol) {
+    FAMILY_OUTPUT *op = arg;
+    fprintf(op -> out, "%s\t", op -> name);
+    dtmf_event_print(op -> out, start, end, symbol);
+}
+
+int tone_detect(FILE *audio_in, const DTMF_DETECTOR_CONFIG *cfg, int families, FILE *events_out) {
+    DTMF_DETECTOR *detectors[NUM_TONE_FAMILIES];
+    FAMILY_OUTPUT outputs[NUM_TONE_FAMILIES];
+    int count = 0;
+    int ret = 0;
+    for (int id = 0; id < NUM_TONE_FAMILIES && ret == 0; id++) {
+        if (!(families & (1 << id))) {
+            continue;
+        }
+        DTMF_DETECTOR_CONFIG fc = *cfg;
+        fc.family = tone_family_get(id);
+        if (fc.family -> block_size != 0) {
+            fc.block_size = fc.family -> block_size;
+        }
+        DTMF_DETECTOR **dpp = detectors + count;
+        FAMILY_OUTPUT *op = outputs + count;
+        *dpp = dtmf_detector_new(&fc);
+        op -> out = events_out;
+        op -> name = fc.family -> name;
+        if (*dpp == NULL) {
+            ret = EOF;
+        } else {
+            count++;
+        }
+    }
+    if (ret == 0) {
+        int16_t samples[SAMPLE_BUF_SIZE];
+        size_t got;
+        while ((got = audio_read_encoded(audio_in, cfg -> encoding, samples, SAMPLE_BUF_SIZE)) > 0) {
+            for (int i = 0; i < count; i++) {
+                dtmf_detector_feed(*(detectors + i), samples, got, print_family_event, outputs + i);
+            }
+        }
+        for (int i = 0; i < count; i++) {
+            dtmf_detector_finish(*(detectors + i), print_family_event, outputs + i);
+        }
+    }
+    for (int i = 0; i < count; i++) {
+        dtmf_detector_free(*(detectors + i));
+    }
+    return ret;
+}
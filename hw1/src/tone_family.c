@@ -0,0 +1,152 @@
+#include <stddef.h>
+#include <stdint.h>
+#include <pthread.h>
+
+#include "const.h"
+#include "debug.h"
+#include "tone_family.h"
+
+/*
+ * The frequencies and symbols of the DTMF family are those of dtmf_freqs and
+ * dtmf_symbol_names, which are filled in by dtmf_family_init when a family is first
+ * asked for, and are then only read, without locking, in all threads.
+ */
+static TONE_FAMILY families[NUM_TONE_FAMILIES] = {
+    {
+        .name = "dtmf", .nfreqs = NUM_DTMF_FREQS, .split = NUM_DTMF_ROW_FREQS, .block_size = 0,
+        .twist = FOUR_DB, .margin = SIX_DB
+    },
+    {
+        // 440 and 480 Hz are only 40 Hz apart, which takes a block of 50 ms to resolve.
+        .name = "cpt", .nfreqs = 4, .split = 0, .block_size = 400,
+        .twist = FOUR_DB, .margin = SIX_DB,
+        .freqs = { 350, 440, 480, 620 },
+        .symbols = {
+            [0] = { [1] = 'D' },
+            [1] = { [2] = 'R' },
+            [2] = { [3] = 'B' }
+        }
+    },
+    {
+        // The shortest MF R1 signals last 68 ms; a 20 ms block resolves 200 Hz steps.
+        .name = "mf", .nfreqs = 6, .split = 0, .block_size = 160,
+        .twist = SIX_DB, .margin = SIX_DB,
+        .freqs = { 700, 900, 1100, 1300, 1500, 1700 },
+        .symbols = {
+            [0] = { [1] = '1', [2] = '2', [3] = '4', [4] = '7', [5] = 'R' },
+            [1] = { [2] = '3', [3] = '5', [4] = '8', [5] = 'P' },
+            [2] = { [3] = '6', [4] = '9', [5] = 'K' },
+            [3] = { [4] = '0', [5] = 'Q' },
+            [4] = { [5] = 'S' }
+        }
+    }
+};
+
+static pthread_once_t dtmf_family_once = PTHREAD_ONCE_INIT;
+
+static void dtmf_family_init(void) {
+    TONE_FAMILY *fp = families + TONE_FAMILY_DTMF;
+    for (int F = 0; F < NUM_DTMF_FREQS; F++) {
+        *(fp -> freqs + F) = *(dtmf_freqs + F);
+    }
+    for (int r = 0; r < NUM_DTMF_ROW_FREQS; r++) {
+        for (int c = 0; c < NUM_DTMF_COL_FREQS; c++) {
+            *(*(fp -> symbols + r) + NUM_DTMF_ROW_FREQS + c) = *(*(dtmf_symbol_names + r) + c);
+        }
+    }
+}
+
+const TONE_FAMILY *tone_family_get(int id) {
+    pthread_once(&dtmf_family_once, dtmf_family_init);
+    return families + id;
+}
+
+int tone_family_find(const char *name, size_t length) {
+    for (int id = 0; id < NUM_TONE_FAMILIES; id++) {
+        const char *p = (families + id) -> name;
+        size_t i = 0;
+        while (i < length && *(p + i) == *(name + i)) {
+            i++;
+        }
+        if (i == length && *(p + i) == '\0') {
+            return id;
+        }
+    }
+    return -1;
+}
+
+void tone_plans_init(GOERTZEL_PLAN *plans, const TONE_FAMILY *fp, int N) {
+    for (int F = 0; F < GOERTZEL_BANK_SIZE; F++) {
+        int f = *(fp -> freqs + (F < fp -> nfreqs ? F : fp -> nfreqs - 1));
+        goertzel_plan_init(plans + F, N, f * N * 1.0 / AUDIO_FRAME_RATE);
+    }
+}
+
+/*
+ * Find the strongest component in [from, to), other than the one at skip.
+ * Ties go to the first, as in dtmf_classify_strengths.
+ */
+static int strongest(const double *strengths, int from, int to, int skip) {
+    int best = from == skip ? from + 1 : from;
+    double strength = 0;
+    for (int i = from; i < to; i++) {
+        if (i != skip && *(strengths + i) > strength) {
+            strength = *(strengths + i);
+            best = i;
+        }
+    }
+    return best;
+}
+
+/*
+ * Check that the component at i is stronger by the margin of the family than every
+ * component in [from, to) other than those at i and j.
+ */
+static int dominates(const TONE_FAMILY *fp, const double *strengths, int i, int j, int from, int to) {
+    for (int k = from; k < to; k++) {
+        if (k != i && k != j && *(strengths + i) < *(strengths + k) * fp -> margin) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+int tone_family_classify(const TONE_FAMILY *fp, const double *strengths) {
+    int a, b;
+    if (fp -> split != 0) {
+        a = strongest(strengths, 0, fp -> split, -1);
+        b = strongest(strengths, fp -> split, fp -> nfreqs, -1);
+    } else {
+        a = strongest(strengths, 0, fp -> nfreqs, -1);
+        b = strongest(strengths, 0, fp -> nfreqs, a);
+    }
+    double sa = *(strengths + a);
+    double sb = *(strengths + b);
+    if (sa + sb < MINUS_20DB) {
+        return 0;
+    }
+    double ratio = sa / sb;
+    if (ratio > fp -> twist || ratio < 1 / fp -> twist) {
+        return 0;
+    }
+    if (fp -> split != 0) {
+        if (!dominates(fp, strengths, a, a, 0, fp -> split)
+            || !dominates(fp, strengths, b, b, fp -> split, fp -> nfreqs)) {
+            return 0;
+        }
+    } else if (!dominates(fp, strengths, sa < sb ? a : b, sa < sb ? b : a, 0, fp -> nfreqs)) {
+        return 0;
+    }
+    return a < b ? *(*(fp -> symbols + a) + b) : *(*(fp -> symbols + b) + a);
+}
+
+double tone_family_power(const TONE_FAMILY *fp, const double *strengths, uint8_t symbol) {
+    for (int i = 0; i < fp -> nfreqs; i++) {
+        for (int j = i + 1; j < fp -> nfreqs; j++) {
+            if (*(*(fp -> symbols + i) + j) == symbol) {
+                return *(strengths + i) + *(strengths + j);
+            }
+        }
+    }
+    return 0;
+}
@@ -2,7 +2,22 @@
 #include <criterion/logging.h>
 #include <string.h>  // You may use this here in the test cases, but not elsewhere.
 #include <math.h>
+#include <unistd.h>
 #include "const.h"
+#include "dtmf_options.h"
+#include "goertzel_bank.h"
+#include "goertzel_plan.h"
+#include "dtmf_tracker.h"
+#include "dtmf_detector.h"
+#include "dtmf_generator.h"
+#include "dtmf_analysis.h"
+#include "dtmf_refine.h"
+#include "tone_family.h"
+#include "dtmf_script.h"
+#include "dtmf_channels.h"
+#include "dtmf_decimator.h"
+#include "dtmf_sidecar.h"
+#include "dtmf_sweep.h"
 
 Test(basecode_tests_suite, validargs_help_test) {
     int argc = 2;
@@ -111,3 +126,1005 @@ Test(basecode_tests_suite, goertzel_additional_test) {
     double eps = 1e-6;
     cr_assert((fabs(r0-0.000003) < eps), "r1 was %f, should be 0.5", r0);
 }
+
+Test(audio_tests_suite, read_samples_matches_read_sample_test) {
+    FILE *fp1 = fopen("./rsrc/dtmf_all.au", "r");
+    FILE *fp2 = fopen("./rsrc/dtmf_all.au", "r");
+    AUDIO_HEADER h1, h2;
+    cr_assert_eq(audio_read_header(fp1, &h1), 0, "Failed to read header");
+    cr_assert_eq(audio_read_header(fp2, &h2), 0, "Failed to read header");
+    int16_t bulk[1000];
+    size_t total = 0;
+    size_t n;
+    while ((n = audio_read_samples(fp1, bulk, 1000)) > 0) {
+        for (size_t i = 0; i < n; i++) {
+            int16_t sample;
+            cr_assert_eq(audio_read_sample(fp2, &sample), 0, "Per-sample read ended early at %zu", total + i);
+            cr_assert_eq(bulk[i], sample, "Sample %zu differs. Got: %d | Expected: %d",
+                         total + i, bulk[i], sample);
+        }
+        total += n;
+    }
+    cr_assert_eq(total, (h1.data_size) / AUDIO_BYTES_PER_SAMPLE,
+                 "Wrong number of samples. Got: %zu | Expected: %u", total, h1.data_size / 2);
+    fclose(fp1);
+    fclose(fp2);
+}
+
+Test(audio_tests_suite, g711_detect_test) {
+    // Reference values from ITU-T G.711, then a DTMF tone encoded to each law by
+    // choosing the nearest code, which must be detected as in the 16-bit original.
+    uint8_t codes[] = { 0x00, 0x7f, 0x80, 0xff, 0xd5, 0x55, 0xaa, 0x2a };
+    int16_t expected[] = { -32124, 0, 32124, 0, 8, -8, 32256, -32256 };
+    int16_t got[8];
+    audio_expand_samples(ULAW_ENCODING, codes, got, 4);
+    audio_expand_samples(ALAW_ENCODING, codes + 4, got + 4, 4);
+    for (int i = 0; i < 8; i++) {
+        cr_assert_eq(got[i], expected[i], "Code %#x expands to %d, expected %d",
+                     codes[i], got[i], expected[i]);
+    }
+    uint32_t encodings[] = { ULAW_ENCODING, ALAW_ENCODING };
+    for (int e = 0; e < 2; e++) {
+        uint8_t all[256];
+        int16_t table[256];
+        for (int c = 0; c < 256; c++) {
+            all[c] = c;
+        }
+        audio_expand_samples(encodings[e], all, table, 256);
+        FILE *file = tmpfile();
+        AUDIO_HEADER hd = { AUDIO_MAGIC, AUDIO_DATA_OFFSET, 12000, encodings[e],
+                            AUDIO_FRAME_RATE, AUDIO_CHANNELS };
+        audio_write_header(file, &hd);
+        for (int i = 0; i < 12000; i++) {
+            double x = 0;
+            if (i >= 4000 && i < 8000) {
+                x = 8000 * (cos(2 * M_PI * 770 * i / AUDIO_FRAME_RATE) +
+                            cos(2 * M_PI * 1336 * i / AUDIO_FRAME_RATE));
+            }
+            int best = 0;
+            for (int c = 1; c < 256; c++) {
+                if (fabs(table[c] - x) < fabs(table[best] - x)) {
+                    best = c;
+                }
+            }
+            fputc(best, file);
+        }
+        rewind(file);
+        char *buf = NULL;
+        size_t size = 0;
+        FILE *out = open_memstream(&buf, &size);
+        block_size = 100;
+        cr_assert_eq(dtmf_detect(file, out), 0, "dtmf_detect failed for encoding %u", encodings[e]);
+        fclose(out);
+        fclose(file);
+        cr_assert_eq(strcmp(buf, "4000\t8000\t5\n"), 0, "Wrong events for encoding %u: %s",
+                     encodings[e], buf);
+        free(buf);
+    }
+}
+
+Test(goertzel_tests_suite, bank_matches_individual_filters_test) {
+    int N = 205;
+    GOERTZEL_STATE single[GOERTZEL_BANK_SIZE], banked[GOERTZEL_BANK_SIZE];
+    int16_t samples[205];
+    for (int i = 0; i < N; i++) {
+        samples[i] = (int16_t)(16000 * cos(2 * M_PI * 770 * i / 8000.0)
+                               + 16000 * cos(2 * M_PI * 1477 * i / 8000.0));
+    }
+    for (int F = 0; F < GOERTZEL_BANK_SIZE; F++) {
+        goertzel_init(&single[F], N, dtmf_freqs[F] * N / 8000.0);
+        goertzel_init(&banked[F], N, dtmf_freqs[F] * N / 8000.0);
+    }
+    for (int i = 0; i < N - 1; i++) {
+        for (int F = 0; F < GOERTZEL_BANK_SIZE; F++) {
+            goertzel_step(&single[F], (double)samples[i] / INT16_MAX);
+        }
+    }
+    GOERTZEL_BANK bank;
+    goertzel_bank_load(&bank, banked);
+    goertzel_bank_run(&bank, samples, N - 1);
+    goertzel_bank_store(&bank, banked);
+    double x = (double)samples[N - 1] / INT16_MAX;
+    for (int F = 0; F < GOERTZEL_BANK_SIZE; F++) {
+        double expected = goertzel_strength(&single[F], x);
+        double got = goertzel_strength(&banked[F], x);
+        cr_assert_eq(got, expected, "Filter %d strength differs. Got: %f | Expected: %f",
+                     F, got, expected);
+    }
+}
+
+Test(goertzel_tests_suite, plan_matches_goertzel_strength_test) {
+    int N = 50;
+    for (int F = 0; F < NUM_DTMF_FREQS; F++) {
+        double k = dtmf_freqs[F] * N / 8000.0;
+        GOERTZEL_PLAN plan;
+        GOERTZEL_STATE g0, g1;
+        goertzel_plan_init(&plan, N, k);
+        goertzel_init(&g0, N, k);
+        goertzel_plan_start(&plan, &g1);
+        double x = 0;
+        for (int i = 0; i < N - 1; i++) {
+            x = cos(2 * M_PI * dtmf_freqs[F] * i / 8000.0);
+            goertzel_step(&g0, x);
+            goertzel_step(&g1, x);
+        }
+        x = cos(2 * M_PI * dtmf_freqs[F] * (N - 1) / 8000.0);
+        double expected = goertzel_strength(&g0, x);
+        double got = goertzel_plan_strength(&plan, &g1, x);
+        cr_assert(fabs(got - expected) < 1e-12, "Frequency %d Hz: got %f, expected %f",
+                  dtmf_freqs[F], got, expected);
+    }
+}
+
+/*
+ * Run dtmf_detect on an audio file with the current settings of the global
+ * option variables, returning the emitted events as a malloc'ed string.
+ */
+static char *detect_events(char *path) {
+    char *buf = NULL;
+    size_t size = 0;
+    FILE *in = fopen(path, "r");
+    FILE *out = open_memstream(&buf, &size);
+    cr_assert_not_null(in, "Could not open %s", path);
+    cr_assert_eq(dtmf_detect(in, out), 0, "dtmf_detect failed on %s", path);
+    fclose(out);
+    fclose(in);
+    return buf;
+}
+
+static char *corpus[] = {
+    "./rsrc/941Hz_1sec.au", "./rsrc/audio.au", "./rsrc/dtmf_0_500ms.au",
+    "./rsrc/dtmf_all.au", "./rsrc/white_noise_10s.au", NULL
+};
+
+Test(goertzel_tests_suite, fixed_engine_matches_float_engine_test) {
+    int sizes[] = {10, 20, 50, 100, 137, 205, 400, 1000, 0};
+    for (char **path = corpus; *path != NULL; path++) {
+        for (int *bs = sizes; *bs != 0; bs++) {
+            block_size = *bs;
+            goertzel_engine = GOERTZEL_ENGINE_FLOAT;
+            char *expected = detect_events(*path);
+            goertzel_engine = GOERTZEL_ENGINE_FIXED;
+            char *got = detect_events(*path);
+            cr_assert_eq(strcmp(got, expected), 0,
+                         "Events differ for %s at block size %d.\nGot:\n%s\nExpected:\n%s",
+                         *path, *bs, got, expected);
+            free(expected);
+            free(got);
+        }
+    }
+    goertzel_engine = GOERTZEL_ENGINE_FLOAT;
+}
+
+Test(goertzel_tests_suite, fft_engine_matches_float_engine_test) {
+    // Every block size, since the bins of the FFT fall differently on the DTMF
+    // frequencies at each one.
+    char *paths[] = { "./rsrc/dtmf_all.au", "./rsrc/audio.au", NULL };
+    for (char **path = paths; *path != NULL; path++) {
+        for (int bs = 10; bs <= 1000; bs++) {
+            block_size = bs;
+            goertzel_engine = GOERTZEL_ENGINE_FLOAT;
+            char *expected = detect_events(*path);
+            goertzel_engine = GOERTZEL_ENGINE_FFT;
+            char *got = detect_events(*path);
+            cr_assert_eq(strcmp(got, expected), 0,
+                         "Events differ for %s at block size %d.\nGot:\n%s\nExpected:\n%s",
+                         *path, bs, got, expected);
+            free(expected);
+            free(got);
+        }
+    }
+    goertzel_engine = GOERTZEL_ENGINE_FLOAT;
+    // The filters are cheaper for a bank of eight frequencies, the FFT for a large one.
+    cr_assert_eq(dtmf_engine_select(GOERTZEL_ENGINE_AUTO, NUM_DTMF_FREQS, 1000),
+                 GOERTZEL_ENGINE_FLOAT, "Expected the filters for the DTMF frequencies");
+    cr_assert_eq(dtmf_engine_select(GOERTZEL_ENGINE_AUTO, 1000, 1000),
+                 GOERTZEL_ENGINE_FFT, "Expected the FFT for a bank of 1000 frequencies");
+}
+
+Test(detect_tests_suite, sliding_window_boundaries_test) {
+    block_size = 100;
+    hop_size = 10;
+    goertzel_engine = GOERTZEL_ENGINE_FLOAT;
+    char *got = detect_events("./rsrc/dtmf_all.au");
+    hop_size = 0;
+    FILE *exp = fopen("./rsrc/dtmf_all.txt", "r");
+    FILE *act = fmemopen(got, strlen(got), "r");
+    int es, ee, as, ae;
+    char ec, ac;
+    int count = 0;
+    while (fscanf(exp, "%d\t%d\t%c", &es, &ee, &ec) == 3) {
+        cr_assert_eq(fscanf(act, "%d\t%d\t%c", &as, &ae, &ac), 3, "Missing event %d", count);
+        cr_assert_eq(ac, ec, "Wrong symbol. Got: %c | Expected: %c", ac, ec);
+        // Boundaries should be within a hop (and on hop boundaries).
+        cr_assert(abs(as - es) <= 10 && abs(ae - ee) <= 10,
+                  "Event %d boundaries too far off. Got: [%d, %d) | Expected: [%d, %d)",
+                  count, as, ae, es, ee);
+        cr_assert(as % 10 == 0, "Start %d is not on a hop boundary", as);
+        count++;
+    }
+    cr_assert_eq(fscanf(act, "%d\t%d\t%c", &as, &ae, &ac), EOF, "Extra events");
+    fclose(exp);
+    fclose(act);
+    free(got);
+}
+
+Test(detect_tests_suite, parallel_matches_sequential_test) {
+    int sizes[] = {50, 100, 137, 1000, 0};
+    hop_size = 0;
+    goertzel_engine = GOERTZEL_ENGINE_FLOAT;
+    for (char **path = corpus; *path != NULL; path++) {
+        for (int *bs = sizes; *bs != 0; bs++) {
+            block_size = *bs;
+            num_jobs = 1;
+            char *expected = detect_events(*path);
+            num_jobs = 7;
+            char *got = detect_events(*path);
+            cr_assert_eq(strcmp(got, expected), 0,
+                         "Events differ for %s at block size %d.\nGot:\n%s\nExpected:\n%s",
+                         *path, *bs, got, expected);
+            free(expected);
+            free(got);
+        }
+    }
+    num_jobs = 1;
+}
+
+Test(detect_tests_suite, pipeline_matches_sequential_test) {
+    // Block-by-block and sliding-window detection.
+    struct { int block, hop; } cases[] = { { 100, 0 }, { 205, 10 } };
+    goertzel_engine = GOERTZEL_ENGINE_FLOAT;
+    for (char **path = corpus; *path != NULL; path++) {
+        for (int c = 0; c < 2; c++) {
+            block_size = cases[c].block;
+            hop_size = cases[c].hop;
+            pipeline_mode = 0;
+            char *expected = detect_events(*path);
+            pipeline_mode = 1;
+            char *got = detect_events(*path);
+            cr_assert_eq(strcmp(got, expected), 0,
+                         "Events differ for %s at block size %d.\nGot:\n%s\nExpected:\n%s",
+                         *path, block_size, got, expected);
+            free(expected);
+            free(got);
+        }
+    }
+    pipeline_mode = 0;
+    hop_size = 0;
+}
+
+Test(detect_tests_suite, interleaved_detectors_test) {
+    // Two detectors with different parameters, fed alternately in pieces that
+    // do not line up with their blocks, must not disturb each other.
+    DTMF_DETECTOR_CONFIG cfg1 = { .block_size = 100, .engine = GOERTZEL_ENGINE_FIXED };
+    DTMF_DETECTOR_CONFIG cfg2 = { .block_size = 205, .hop_size = 41 };
+    DTMF_DETECTOR *d1 = dtmf_detector_new(&cfg1);
+    DTMF_DETECTOR *d2 = dtmf_detector_new(&cfg2);
+    cr_assert_not_null(d1, "Could not create detector");
+    cr_assert_not_null(d2, "Could not create detector");
+    char *buf1 = NULL, *buf2 = NULL;
+    size_t size1 = 0, size2 = 0;
+    FILE *out1 = open_memstream(&buf1, &size1);
+    FILE *out2 = open_memstream(&buf2, &size2);
+    FILE *in = fopen("./rsrc/dtmf_all.au", "r");
+    AUDIO_HEADER hd;
+    cr_assert_eq(audio_read_header(in, &hd), 0, "Could not read header");
+    int16_t samples[160];
+    size_t got;
+    while ((got = audio_read_samples(in, samples, 160)) > 0) {
+        dtmf_detector_feed(d1, samples, got, dtmf_event_print, out1);
+        dtmf_detector_feed(d2, samples, got, dtmf_event_print, out2);
+    }
+    dtmf_detector_finish(d1, dtmf_event_print, out1);
+    dtmf_detector_finish(d2, dtmf_event_print, out2);
+    dtmf_detector_free(d1);
+    dtmf_detector_free(d2);
+    fclose(in);
+    fclose(out1);
+    fclose(out2);
+
+    block_size = 100;
+    hop_size = 0;
+    goertzel_engine = GOERTZEL_ENGINE_FIXED;
+    char *expected1 = detect_events("./rsrc/dtmf_all.au");
+    block_size = 205;
+    hop_size = 41;
+    goertzel_engine = GOERTZEL_ENGINE_FLOAT;
+    char *expected2 = detect_events("./rsrc/dtmf_all.au");
+    hop_size = 0;
+    cr_assert_eq(strcmp(buf1, expected1), 0, "Got:\n%s\nExpected:\n%s", buf1, expected1);
+    cr_assert_eq(strcmp(buf2, expected2), 0, "Got:\n%s\nExpected:\n%s", buf2, expected2);
+    free(buf1);
+    free(buf2);
+    free(expected1);
+    free(expected2);
+}
+
+/*
+ * Event reporting function that records opened and closed events.
+ */
+typedef struct event_log {
+    int count;
+    int start[64];
+    int end[64];
+    uint8_t symbol[64];
+} EVENT_LOG;
+
+static void log_event(void *arg, int start, int end, uint8_t symbol) {
+    EVENT_LOG *lp = arg;
+    cr_assert(lp -> count < 64, "Too many events");
+    lp -> start[lp -> count] = start;
+    lp -> end[lp -> count] = end;
+    lp -> symbol[lp -> count] = symbol;
+    lp -> count++;
+}
+
+Test(detect_tests_suite, packet_push_test) {
+    DTMF_DETECTOR_CONFIG cfg = { .block_size = 100, .flags = DTMF_TRACKER_ONSET };
+    DTMF_DETECTOR *dp = dtmf_detector_new(&cfg);
+    cr_assert_not_null(dp, "Could not create detector");
+    FILE *in = fopen("./rsrc/dtmf_all.au", "r");
+    AUDIO_HEADER hd;
+    cr_assert_eq(audio_read_header(in, &hd), 0, "Could not read header");
+    int16_t samples[16000];
+    size_t n = audio_read_samples(in, samples, 16000);
+    fclose(in);
+    // Push the same call twice, in 20 ms packets, resetting in between.
+    for (int pass = 0; pass < 2; pass++) {
+        EVENT_LOG log = { 0 };
+        for (size_t i = 0; i < n; i += 160) {
+            dtmf_detector_feed(dp, samples + i, n - i < 160 ? n - i : 160, log_event, &log);
+        }
+        dtmf_detector_finish(dp, log_event, &log);
+        dtmf_detector_reset(dp);
+        FILE *exp = fopen("./rsrc/dtmf_all.txt", "r");
+        int es, ee;
+        char ec;
+        int i = 0;
+        while (fscanf(exp, "%d\t%d\t%c", &es, &ee, &ec) == 3 && es < (int)n) {
+            cr_assert(i + 1 < log.count, "Missing event at %d", es);
+            cr_assert(log.start[i] == es && log.end[i] == -1 && log.symbol[i] == ec,
+                      "Expected open of %c at %d, got %c at %d (end %d)",
+                      ec, es, log.symbol[i], log.start[i], log.end[i]);
+            cr_assert(log.start[i + 1] == es && log.end[i + 1] == ee && log.symbol[i + 1] == ec,
+                      "Expected close of %c at [%d, %d), got %c at [%d, %d)",
+                      ec, es, ee, log.symbol[i + 1], log.start[i + 1], log.end[i + 1]);
+            i += 2;
+        }
+        cr_assert_eq(i, log.count, "Extra events");
+        fclose(exp);
+    }
+    dtmf_detector_free(dp);
+}
+
+static void log_channel_event(void *arg, int channel, int start, int end, uint8_t symbol) {
+    log_event((EVENT_LOG *)arg + channel, start, end, symbol);
+}
+
+Test(detect_tests_suite, channels_match_mono_test) {
+    // Two channels: the start of dtmf_all.au, and the same delayed by 1037 samples.
+    FILE *in = fopen("./rsrc/dtmf_all.au", "r");
+    AUDIO_HEADER hd;
+    cr_assert_eq(audio_read_header(in, &hd), 0, "Could not read header");
+    static int16_t legs[2][16000];
+    size_t n = audio_read_samples(in, legs[0], 16000);
+    fclose(in);
+    for (size_t i = 0; i < n; i++) {
+        legs[1][i] = i < 1037 ? 0 : legs[0][i - 1037];
+    }
+    FILE *file = tmpfile();
+    AUDIO_HEADER out = { AUDIO_MAGIC, AUDIO_DATA_OFFSET, 4 * n, PCM16_ENCODING, AUDIO_FRAME_RATE, 2 };
+    audio_write_header(file, &out);
+    for (size_t i = 0; i < n; i++) {
+        audio_write_sample(file, legs[0][i]);
+        audio_write_sample(file, legs[1][i]);
+    }
+    rewind(file);
+    cr_assert_eq(audio_read_header(file, &hd), 0, "Could not read two-channel header");
+    DTMF_DETECTOR_CONFIG cfg = { .block_size = 100 };
+    EVENT_LOG got[2] = { { 0 }, { 0 } };
+    cr_assert_eq(dtmf_detect_channels(file, &cfg, hd.channels, log_channel_event, got), 0,
+                 "dtmf_detect_channels failed");
+    fclose(file);
+    for (int c = 0; c < 2; c++) {
+        EVENT_LOG expected = { 0 };
+        DTMF_DETECTOR *dp = dtmf_detector_new(&cfg);
+        dtmf_detector_feed(dp, legs[c], n, log_event, &expected);
+        dtmf_detector_finish(dp, log_event, &expected);
+        dtmf_detector_free(dp);
+        cr_assert(expected.count > 0, "No events in channel %d", c);
+        cr_assert_eq(got[c].count, expected.count, "Channel %d has %d events, expected %d",
+                     c, got[c].count, expected.count);
+        for (int i = 0; i < expected.count; i++) {
+            cr_assert(got[c].start[i] == expected.start[i] && got[c].end[i] == expected.end[i]
+                      && got[c].symbol[i] == expected.symbol[i],
+                      "Channel %d event %d differs", c, i);
+        }
+    }
+}
+
+Test(detect_tests_suite, sample_rate_test) {
+    // A '5' from 0.5 s to 1 s, then a 770 Hz tone with a strong 6664 Hz component,
+    // which would alias onto 1336 Hz, and so make another '5', without the filter.
+    // The event is found where it is at 8 kHz, in samples of the input.
+    uint32_t rates[] = { 16000, 44100, 48000 };
+    int expected[][2] = { { 8000, 16000 }, { 22050, 44100 }, { 24000, 48000 } };
+    static int16_t samples[72000];
+    for (int r = 0; r < 3; r++) {
+        int rate = rates[r];
+        int n = rate * 3 / 2;
+        for (int i = 0; i < n; i++) {
+            double t = (double)i / rate;
+            double x = 0;
+            if (t >= 0.5 && t < 1.0) {
+                x = 8000 * (cos(2 * M_PI * 770 * t) + cos(2 * M_PI * 1336 * t));
+            } else if (t >= 1.0) {
+                x = 8000 * (cos(2 * M_PI * 770 * t) + cos(2 * M_PI * 6664 * t));
+            }
+            samples[i] = (int16_t)x;
+        }
+        DTMF_DETECTOR_CONFIG cfg = { .block_size = 100, .sample_rate = rate };
+        DTMF_DETECTOR *dp = dtmf_detector_new(&cfg);
+        cr_assert_not_null(dp, "Could not create detector for %d Hz", rate);
+        EVENT_LOG log = { 0 };
+        for (int i = 0; i < n; i += rate / 50) {
+            dtmf_detector_feed(dp, samples + i, n - i < rate / 50 ? n - i : rate / 50, log_event, &log);
+        }
+        dtmf_detector_finish(dp, log_event, &log);
+        dtmf_detector_free(dp);
+        cr_assert_eq(log.count, 1, "%d events at %d Hz, expected 1", log.count, rate);
+        cr_assert(log.start[0] == expected[r][0] && log.end[0] == expected[r][1] && log.symbol[0] == '5',
+                  "Expected 5 at [%d, %d) at %d Hz, got %c at [%d, %d)", expected[r][0],
+                  expected[r][1], rate, log.symbol[0], log.start[0], log.end[0]);
+    }
+}
+
+Test(detect_tests_suite, sample_rate_header_test) {
+    // Only the rates that can be decimated to 8000 Hz are accepted in a header:
+    // 44057 Hz is in range, but its ratio to 8000 Hz needs far too many phases.
+    uint32_t rates[] = { 11025, 44057, 7999, 192000 };
+    int expected[] = { 0, EOF, EOF, 0 };
+    for (int r = 0; r < 4; r++) {
+        FILE *file = tmpfile();
+        AUDIO_HEADER out = { AUDIO_MAGIC, AUDIO_DATA_OFFSET, 0, PCM16_ENCODING, rates[r], 1 };
+        audio_write_header(file, &out);
+        rewind(file);
+        AUDIO_HEADER hd;
+        int ret = audio_read_header(file, &hd);
+        fclose(file);
+        cr_assert_eq(ret, expected[r], "Header at %u Hz: got %d, expected %d", rates[r],
+                     ret, expected[r]);
+        cr_assert_eq(dtmf_decimator_supported(rates[r]), expected[r] == 0,
+                     "Decimator disagrees with the header at %u Hz", rates[r]);
+    }
+}
+
+Test(detect_tests_suite, sidecar_redecide_test) {
+    // Re-deciding a sidecar with the default thresholds gives the detector's events;
+    // requiring events to last longer than the 50 ms tones of dtmf_all.au leaves none.
+    char path[] = "/tmp/hw1_sidecar_XXXXXX";
+    close(mkstemp(path));
+    FILE *in = fopen("./rsrc/dtmf_all.au", "r");
+    AUDIO_HEADER hd;
+    cr_assert_eq(audio_read_header(in, &hd), 0, "Could not read header");
+    int16_t samples[16000];
+    size_t n = audio_read_samples(in, samples, 16000);
+    fclose(in);
+    DTMF_DETECTOR_CONFIG cfg = { .block_size = 100 };
+    cfg.sidecar = dtmf_sidecar_create(path, cfg.block_size, 0, 0);
+    cr_assert_not_null(cfg.sidecar, "Could not create sidecar");
+    DTMF_DETECTOR *dp = dtmf_detector_new(&cfg);
+    EVENT_LOG expected = { 0 };
+    dtmf_detector_feed(dp, samples, n, log_event, &expected);
+    dtmf_detector_finish(dp, log_event, &expected);
+    dtmf_detector_free(dp);
+    cr_assert_eq(dtmf_sidecar_close(cfg.sidecar), 0, "Could not write sidecar");
+    EVENT_LOG got = { 0 };
+    cr_assert_eq(dtmf_redecide(path, &dtmf_default_thresholds, log_event, &got), 0,
+                 "Could not re-decide sidecar");
+    cr_assert(expected.count > 0, "No events");
+    cr_assert_eq(got.count, expected.count, "%d events, expected %d", got.count, expected.count);
+    for (int i = 0; i < expected.count; i++) {
+        cr_assert(got.start[i] == expected.start[i] && got.end[i] == expected.end[i]
+                  && got.symbol[i] == expected.symbol[i], "Event %d differs", i);
+    }
+    DTMF_THRESHOLDS longer;
+    cr_assert_eq(dtmf_thresholds_parse("twist=4,twist=5", &longer), -1, "Repeated setting");
+    cr_assert_eq(dtmf_thresholds_parse("level=4", &longer), -1, "Unknown setting");
+    cr_assert_eq(dtmf_thresholds_parse("twist=4,duration=60", &longer), 0, "Could not parse");
+    EVENT_LOG none = { 0 };
+    cr_assert_eq(dtmf_redecide(path, &longer, log_event, &none), 0, "Could not re-decide sidecar");
+    cr_assert_eq(none.count, 0, "%d events longer than 60 ms", none.count);
+    unlink(path);
+}
+
+Test(detect_tests_suite, sidecar_removed_on_failure_test) {
+    // A detector that cannot be created (sliding windows need the float engine)
+    // leaves no sidecar behind.
+    char path[] = "/tmp/hw1_sidecar_XXXXXX";
+    close(mkstemp(path));
+    unlink(path);
+    block_size = 100;
+    hop_size = 10;
+    goertzel_engine = GOERTZEL_ENGINE_FIXED;
+    sidecar_file = path;
+    FILE *in = fopen("./rsrc/dtmf_all.au", "r");
+    FILE *out = tmpfile();
+    int ret = dtmf_detect(in, out);
+    fclose(in);
+    fclose(out);
+    hop_size = 0;
+    goertzel_engine = GOERTZEL_ENGINE_FLOAT;
+    sidecar_file = NULL;
+    cr_assert_eq(ret, EOF, "Detection should have failed.  Got: %d", ret);
+    cr_assert_eq(access(path, F_OK), -1, "Sidecar %s was left behind", path);
+}
+
+Test(detect_tests_suite, sweep_matches_single_size_test) {
+    // Each block size of a sweep finds the events that a detector of that size alone finds.
+    char *spec = "205,80-100:10";
+    int sizes[SWEEP_MAX_SIZES];
+    int count = dtmf_sweep_parse(spec, sizes, SWEEP_MAX_SIZES);
+    cr_assert(count == 4 && sizes[0] == 205 && sizes[1] == 80 && sizes[3] == 100,
+              "Wrong sizes from %s", spec);
+    cr_assert_eq(dtmf_sweep_parse("9", NULL, SWEEP_MAX_SIZES), -1, "Size too small");
+    cr_assert_eq(dtmf_sweep_parse("100,90-110:10", NULL, SWEEP_MAX_SIZES), -1, "Repeated size");
+    cr_assert_eq(dtmf_sweep_parse("20-10", NULL, SWEEP_MAX_SIZES), -1, "Empty range");
+    cr_assert_eq(dtmf_sweep_parse("10-20,", NULL, SWEEP_MAX_SIZES), -1, "Empty item");
+    FILE *in = fopen("./rsrc/dtmf_all.au", "r");
+    AUDIO_HEADER hd;
+    cr_assert_eq(audio_read_header(in, &hd), 0, "Could not read header");
+    FILE *events = tmpfile();
+    FILE *stats = tmpfile();
+    DTMF_DETECTOR_CONFIG cfg = { .encoding = hd.encoding, .sample_rate = hd.sample_rate };
+    cr_assert_eq(dtmf_detect_sweep(in, &cfg, spec, events, stats), 0, "Sweep failed");
+    int16_t samples[16000];
+    rewind(in);
+    audio_read_header(in, &hd);
+    size_t n = audio_read_samples(in, samples, 16000);
+    fclose(in);
+    for (int k = 0; k < count; k++) {
+        cfg.block_size = sizes[k];
+        DTMF_DETECTOR *dp = dtmf_detector_new(&cfg);
+        EVENT_LOG expected = { 0 };
+        dtmf_detector_feed(dp, samples, n, log_event, &expected);
+        dtmf_detector_finish(dp, log_event, &expected);
+        dtmf_detector_free(dp);
+        cr_assert(expected.count > 0, "No events with size %d", sizes[k]);
+        EVENT_LOG got = { 0 };
+        int size, start, end;
+        char symbol;
+        rewind(events);
+        while (fscanf(events, "%d\t%d\t%d\t%c\n", &size, &start, &end, &symbol) == 4) {
+            if (size == sizes[k]) {
+                log_event(&got, start, end, symbol);
+            }
+        }
+        cr_assert_eq(got.count, expected.count, "%d events with size %d, expected %d",
+                     got.count, sizes[k], expected.count);
+        for (int i = 0; i < expected.count; i++) {
+            cr_assert(got.start[i] == expected.start[i] && got.end[i] == expected.end[i]
+                      && got.symbol[i] == expected.symbol[i], "Event %d with size %d differs",
+                      i, sizes[k]);
+        }
+    }
+    fclose(events);
+    char line[100];
+    int lines = 0;
+    rewind(stats);
+    while (fgets(line, sizeof(line), stats) != NULL) {
+        lines++;
+    }
+    fclose(stats);
+    cr_assert_eq(lines, count + 1, "%d lines of summary, expected %d", lines, count + 1);
+}
+
+Test(detect_tests_suite, refine_boundaries_test) {
+    // Events that begin and end away from any block boundary are located to within
+    // one fine block, although the fine blocks are too short to classify on their own.
+    char *events = "1234\t3456\t5\n5021\t7777\t#\n9090\t10500\tA\n";
+    int expect[3][2] = { { 1234, 3456 }, { 5021, 7777 }, { 9090, 10500 } };
+    noise_file = NULL;
+    noise_level = 0;
+    num_jobs = 1;
+    FILE *in = fmemopen(events, strlen(events), "r");
+    FILE *file = tmpfile();
+    cr_assert_eq(dtmf_generate(in, file, 12000), 0, "Generation failed");
+    fclose(in);
+    rewind(file);
+    AUDIO_HEADER hd;
+    cr_assert_eq(audio_read_header(file, &hd), 0, "Could not read header");
+    DTMF_DETECTOR_CONFIG cfg = { .block_size = 20 };
+    EVENT_LOG log = { 0 };
+    cr_assert_eq(dtmf_detect_refine(file, &cfg, 160, log_event, &log), 0, "Detection failed");
+    fclose(file);
+    cr_assert_eq(log.count, 3, "Wrong event count. Got: %d | Expected: 3", log.count);
+    for (int i = 0; i < 3; i++) {
+        cr_assert(abs(log.start[i] - expect[i][0]) < 20 && abs(log.end[i] - expect[i][1]) < 20,
+                  "Expected [%d, %d), got [%d, %d)", expect[i][0], expect[i][1],
+                  log.start[i], log.end[i]);
+        cr_assert_eq(log.symbol[i], "5#A"[i], "Wrong symbol. Got: %c | Expected: %c",
+                     log.symbol[i], "5#A"[i]);
+    }
+}
+
+Test(detect_tests_suite, refine_partial_coarse_test) {
+    // The input ends halfway through a coarse block, and a tone runs into those last
+    // fine blocks, which have no complete coarse block of their own to go by.
+    char *events = "100\t3280\t5\n";
+    noise_file = NULL;
+    noise_level = 0;
+    num_jobs = 1;
+    FILE *in = fmemopen(events, strlen(events), "r");
+    FILE *file = tmpfile();
+    cr_assert_eq(dtmf_generate(in, file, 3280), 0, "Generation failed");
+    fclose(in);
+    rewind(file);
+    AUDIO_HEADER hd;
+    cr_assert_eq(audio_read_header(file, &hd), 0, "Could not read header");
+    DTMF_DETECTOR_CONFIG cfg = { .block_size = 20 };
+    EVENT_LOG log = { 0 };
+    cr_assert_eq(dtmf_detect_refine(file, &cfg, 160, log_event, &log), 0, "Detection failed");
+    fclose(file);
+    cr_assert_eq(log.count, 1, "Wrong event count. Got: %d | Expected: 1", log.count);
+    cr_assert(abs(log.start[0] - 100) < 20 && abs(log.end[0] - 3280) < 20,
+              "Expected [100, 3280), got [%d, %d)", log.start[0], log.end[0]);
+    cr_assert_eq(log.symbol[0], '5', "Wrong symbol. Got: %c | Expected: 5", log.symbol[0]);
+}
+
+Test(detect_tests_suite, dtmf_family_matches_classify_test) {
+    // The table-driven decision for the DTMF family must be exactly the original one,
+    // including near the thresholds, so strengths are drawn from a few nearby levels.
+    const TONE_FAMILY *fp = tone_family_get(TONE_FAMILY_DTMF);
+    double levels[] = { 0, 0.001, 0.002, 0.004, 0.005, 0.008, 0.01, 0.02, 0.05 };
+    unsigned seed = 12345;
+    for (int t = 0; t < 200000; t++) {
+        double strengths[NUM_DTMF_FREQS];
+        for (int F = 0; F < NUM_DTMF_FREQS; F++) {
+            seed = seed * 1103515245 + 12345;
+            strengths[F] = levels[(seed >> 16) % 9];
+        }
+        cr_assert_eq(tone_family_classify(fp, strengths), dtmf_classify_strengths(strengths),
+                     "Decisions differ on trial %d", t);
+    }
+}
+
+Test(detect_tests_suite, tone_families_test) {
+    // Call progress and MF R1 tones are found by detectors configured with their families.
+    struct { int id, start, end, f1, f2; uint8_t symbol; } tones[] = {
+        { TONE_FAMILY_CPT, 0, 8000, 350, 440, 'D' },
+        { TONE_FAMILY_CPT, 12000, 28000, 440, 480, 'R' },
+        { TONE_FAMILY_MF, 30000, 30800, 1100, 1700, 'K' },
+        { TONE_FAMILY_MF, 31600, 32144, 1300, 1500, '0' },
+    };
+    static int16_t samples[34000];
+    for (int i = 0; i < 34000; i++) {
+        samples[i] = 0;
+    }
+    for (int t = 0; t < 4; t++) {
+        for (int i = tones[t].start; i < tones[t].end; i++) {
+            samples[i] = (int16_t)(10000 * (cos(2 * M_PI * tones[t].f1 * i / AUDIO_FRAME_RATE) +
+                                            cos(2 * M_PI * tones[t].f2 * i / AUDIO_FRAME_RATE)));
+        }
+    }
+    for (int id = TONE_FAMILY_CPT; id <= TONE_FAMILY_MF; id++) {
+        const TONE_FAMILY *fp = tone_family_get(id);
+        DTMF_DETECTOR_CONFIG cfg = { .block_size = fp -> block_size, .family = fp };
+        DTMF_DETECTOR *dp = dtmf_detector_new(&cfg);
+        cr_assert_not_null(dp, "Could not create detector");
+        EVENT_LOG log = { 0 };
+        dtmf_detector_feed(dp, samples, 34000, log_event, &log);
+        dtmf_detector_finish(dp, log_event, &log);
+        dtmf_detector_free(dp);
+        int i = 0;
+        for (int t = 0; t < 4; t++) {
+            if (tones[t].id != id) {
+                continue;
+            }
+            cr_assert(i < log.count, "Missing %s tone %c", fp -> name, tones[t].symbol);
+            cr_assert(log.symbol[i] == tones[t].symbol
+                      && abs(log.start[i] - tones[t].start) < fp -> block_size
+                      && abs(log.end[i] - tones[t].end) < fp -> block_size,
+                      "Expected %c at [%d, %d), got %c at [%d, %d)", tones[t].symbol,
+                      tones[t].start, tones[t].end, log.symbol[i], log.start[i], log.end[i]);
+            i++;
+        }
+        cr_assert_eq(i, log.count, "Extra %s events", fp -> name);
+    }
+}
+
+Test(detect_tests_suite, batch_matches_single_file_test) {
+    char *argv[] = {"bin/dtmf", "-d", "-j", "3", "./rsrc/941Hz_1sec.au", "./rsrc/audio.au",
+                    "./rsrc/dtmf_0_500ms.au", "./rsrc/dtmf_all.au", "./rsrc/white_noise_10s.au", NULL};
+    int ret = validargs(9, argv);
+    cr_assert_eq(ret, 0, "Invalid return for valid args.  Got: %d | Expected: %d", ret, 0);
+    cr_assert_eq(batch_count, 5, "Wrong number of files. Got: %d | Expected: %d", batch_count, 5);
+    char *buf = NULL;
+    size_t size = 0;
+    FILE *out = open_memstream(&buf, &size);
+    cr_assert_eq(dtmf_detect(stdin, out), 0, "Batch detection failed");
+    fclose(out);
+    batch_mode = 0;
+
+    // The same events as for each file on its own, in order, with the file name prefixed.
+    char *exp_buf = NULL;
+    size_t exp_size = 0;
+    FILE *exp = open_memstream(&exp_buf, &exp_size);
+    for (char **path = corpus; *path != NULL; path++) {
+        char *events = detect_events(*path);
+        for (char *line = strtok(events, "\n"); line != NULL; line = strtok(NULL, "\n")) {
+            fprintf(exp, "%s\t%s\n", *path, line);
+        }
+        free(events);
+    }
+    fclose(exp);
+    cr_assert_eq(strcmp(buf, exp_buf), 0, "Got:\n%s\nExpected:\n%s", buf, exp_buf);
+    free(buf);
+    free(exp_buf);
+}
+
+Test(detect_tests_suite, batch_write_bad_input_test) {
+    // An input that is not audio leaves no events file behind to be taken for "no tones".
+    char dir[] = "/tmp/hw1_batch_XXXXXX";
+    cr_assert_neq(mkdtemp(dir), NULL, "Could not create %s", dir);
+    char au[64], txt[64];
+    snprintf(au, sizeof(au), "%s/bad.au", dir);
+    snprintf(txt, sizeof(txt), "%s/bad.txt", dir);
+    FILE *f = fopen(au, "w");
+    fputs("not audio\n", f);
+    fclose(f);
+    char *argv[] = {"bin/dtmf", "-d", "-w", au, NULL};
+    int ret = validargs(4, argv);
+    cr_assert_eq(ret, 0, "Invalid return for valid args.  Got: %d | Expected: %d", ret, 0);
+    FILE *out = tmpfile();
+    ret = dtmf_detect(stdin, out);
+    fclose(out);
+    batch_mode = 0;
+    int left = access(txt, F_OK);
+    unlink(txt);
+    unlink(au);
+    rmdir(dir);
+    cr_assert_eq(ret, EOF, "Detection should have failed.  Got: %d", ret);
+    cr_assert_eq(left, -1, "Events file %s was left behind", txt);
+}
+
+Test(detect_tests_suite, validargs_stream_test) {
+    char *argv[] = {"bin/dtmf", "-d", "-s", "-b", "50", "-o", NULL};
+    int ret = validargs(6, argv);
+    cr_assert_eq(ret, 0, "Invalid return for valid args.  Got: %d | Expected: %d", ret, 0);
+    cr_assert_eq(stream_mode, DTMF_TRACKER_STREAM | DTMF_TRACKER_ONSET,
+                 "Stream mode not properly set. Got: %x", stream_mode);
+    cr_assert_eq(block_size, 50, "Block size not properly set. Got: %d | Expected: %d",
+                 block_size, 50);
+    char *argv2[] = {"bin/dtmf", "-d", "-o", NULL};
+    ret = validargs(3, argv2);
+    cr_assert_eq(ret, -1, "-o without -s should be rejected.  Got: %d | Expected: %d", ret, -1);
+}
+
+Test(detect_tests_suite, validargs_hop_jobs_test) {
+    char *argv[] = {"bin/dtmf", "-d", "-H", "10", "-j", "4", NULL};
+    int ret = validargs(6, argv);
+    cr_assert_eq(ret, -1, "-H with -j should be rejected.  Got: %d | Expected: %d", ret, -1);
+    char *argv2[] = {"bin/dtmf", "-d", "-H", "10", "-j", "4", "./rsrc/dtmf_all.au", NULL};
+    ret = validargs(7, argv2);
+    cr_assert_eq(ret, 0, "-H with -j and files is valid.  Got: %d | Expected: %d", ret, 0);
+    batch_mode = 0;
+    hop_size = 0;
+    num_jobs = 1;
+}
+
+Test(detect_tests_suite, validargs_tones_jobs_test) {
+    char *argv[] = {"bin/dtmf", "-d", "-T", "dtmf,mf", NULL};
+    int ret = validargs(4, argv);
+    cr_assert_eq(ret, 0, "Invalid return for valid args.  Got: %d | Expected: %d", ret, 0);
+    char *argv2[] = {"bin/dtmf", "-d", "-T", "dtmf,mf", "-j", "4", NULL};
+    ret = validargs(6, argv2);
+    cr_assert_eq(ret, -1, "-T with -j should be rejected.  Got: %d | Expected: %d", ret, -1);
+    tone_families = 0;
+    num_jobs = 1;
+}
+
+Test(detect_tests_suite, validargs_coarse_test) {
+    char *argv[] = {"bin/dtmf", "-d", "-b", "20", "-c", "160", NULL};
+    int ret = validargs(6, argv);
+    cr_assert_eq(ret, 0, "Invalid return for valid args.  Got: %d | Expected: %d", ret, 0);
+    cr_assert_eq(coarse_size, 160, "Coarse size not properly set. Got: %d | Expected: %d",
+                 coarse_size, 160);
+    char *argv2[] = {"bin/dtmf", "-d", "-b", "20", "-c", "160", "-j", "4", NULL};
+    ret = validargs(8, argv2);
+    cr_assert_eq(ret, -1, "-c with -j should be rejected.  Got: %d | Expected: %d", ret, -1);
+}
+
+Test(detect_tests_suite, energy_gate_test) {
+    // A pure dual tone puts as much of its energy into the two strongest components
+    // as any signal can, so it is the case in which the gate bound is tightest.
+    // Every block that the gate skips must be one that the filters reject anyway.
+    int sizes[] = { 10, 100, 205, 1000 };
+    for (int s = 0; s < 4; s++) {
+        int N = sizes[s];
+        GOERTZEL_PLAN plans[NUM_DTMF_FREQS];
+        dtmf_plans_init(plans, N);
+        int16_t samples[1000];
+        double strengths[NUM_DTMF_FREQS];
+        for (int r = 0; r < NUM_DTMF_ROW_FREQS; r++) {
+            int c = (r + s) % NUM_DTMF_COL_FREQS;
+            int skipped = 0;
+            for (int amp = 0; amp < 4000; amp += 10) {
+                for (int i = 0; i < N; i++) {
+                    samples[i] = (int16_t)(amp * (cos(2 * M_PI * dtmf_freqs[r] * i / AUDIO_FRAME_RATE) +
+                                                  cos(2 * M_PI * dtmf_freqs[4 + c] * i / AUDIO_FRAME_RATE)));
+                }
+                if (!dtmf_block_quiet(samples, N)) {
+                    continue;
+                }
+                skipped++;
+                for (int e = GOERTZEL_ENGINE_FLOAT; e <= GOERTZEL_ENGINE_FIXED; e++) {
+                    cr_assert_eq(dtmf_analyze_block(plans, e, samples, strengths), 0,
+                                 "Gate skipped a tone at N=%d, amplitude %d", N, amp);
+                    cr_assert_lt(strengths[r] + strengths[4 + c], MINUS_20DB,
+                                 "Gate bound violated at N=%d, amplitude %d", N, amp);
+                }
+            }
+            cr_assert_gt(skipped, 0, "Gate never applied at N=%d", N);
+        }
+    }
+}
+
+Test(generate_tests_suite, tone_table_matches_direct_test) {
+    // Tones produced from the waveform tables must be exactly those computed
+    // directly, even far into the output, where the direct computation rounds.
+    DTMF_GENERATOR_CONFIG cfg = { .noise_file = NULL, .noise_level = 0 };
+    DTMF_GENERATOR *gp = dtmf_generator_new(&cfg);
+    cr_assert_not_null(gp, "Could not create generator");
+    int16_t samples[4000];
+    int index = 0;
+    for (int s = 0; s < NUM_DTMF_FREQS * 2; s++) {
+        int r = s % NUM_DTMF_ROW_FREQS, c = s / NUM_DTMF_ROW_FREQS % NUM_DTMF_COL_FREQS;
+        int Fr = dtmf_freqs[r], Fc = dtmf_freqs[NUM_DTMF_ROW_FREQS + c];
+        // Skip ahead, to an index that is not a multiple of the period.
+        for (int skip = 0; skip < 500; skip++) {
+            dtmf_generator_render(gp, 0, samples, 4000);
+        }
+        index += 500 * 4000 + 4000;
+        dtmf_generator_render(gp, dtmf_symbol_names[r][c], samples, 3997);
+        for (int j = 0; j < 3997; j++) {
+            int i = index - 4000 + j;
+            double a = cos(2.0 * M_PI * Fr * i / AUDIO_FRAME_RATE);
+            double b = cos(2.0 * M_PI * Fc * i / AUDIO_FRAME_RATE);
+            int16_t expected = (int16_t)((a + b) * 0.5 * INT16_MAX);
+            cr_assert_eq(samples[j], expected, "Sample %d of %c differs. Got: %d | Expected: %d",
+                         i, dtmf_symbol_names[r][c], samples[j], expected);
+        }
+        index -= 3;
+    }
+    dtmf_generator_free(gp);
+}
+
+Test(generate_tests_suite, shared_noise_test) {
+    DTMF_NOISE *np = dtmf_noise_open("./rsrc/dtmf_0_500ms.au");
+    cr_assert_not_null(np, "Could not open noise");
+    size_t len = dtmf_noise_length(np);
+    cr_assert_eq(len, 4000, "Wrong noise length. Got: %zu | Expected: %d", len, 4000);
+    // A generator that opens the noise file itself, and two that share a source.
+    DTMF_GENERATOR_CONFIG own = { .noise_file = "./rsrc/dtmf_0_500ms.au", .noise_level = -3 };
+    DTMF_GENERATOR_CONFIG shared = { .noise = np, .noise_level = -3 };
+    DTMF_GENERATOR_CONFIG looped = { .noise = np, .noise_level = 0, .noise_loop = 1 };
+    DTMF_GENERATOR *g1 = dtmf_generator_new(&own);
+    DTMF_GENERATOR *g2 = dtmf_generator_new(&shared);
+    DTMF_GENERATOR *g3 = dtmf_generator_new(&looped);
+    cr_assert(g1 != NULL && g2 != NULL && g3 != NULL, "Could not create generators");
+    int16_t a[6000], b[6000], c[12000];
+    for (int i = 0; i < 6000; i += 1000) {
+        uint8_t symbol = i % 2000 ? '5' : 0;
+        dtmf_generator_render(g1, symbol, a + i, 1000);
+        dtmf_generator_render(g2, symbol, b + i, 1000);
+    }
+    for (int i = 0; i < 6000; i++) {
+        cr_assert_eq(a[i], b[i], "Sample %d differs. Got: %d | Expected: %d", i, b[i], a[i]);
+    }
+    // Beyond the end of the noise, silence is silent unless the noise is looped.
+    cr_assert_eq(a[4500], 0, "Silence after the noise should be silent");
+    dtmf_generator_render(g3, 0, c, 12000);
+    for (int i = 0; i < 8000; i++) {
+        cr_assert_eq(c[i + 4000], c[i], "Looped noise differs at %d", i + 4000);
+    }
+    cr_assert_neq(c[4500], 0, "Looped noise should not be silent");
+    dtmf_generator_free(g1);
+    dtmf_generator_free(g2);
+    dtmf_generator_free(g3);
+    dtmf_noise_close(np);
+}
+
+/*
+ * Generate audio for a script of events twice, to a stream with one job and to a
+ * regular file with the specified number of jobs, and check that the outputs are
+ * the same, byte for byte.
+ */
+static void assert_file_output_matches(char *events, uint32_t length, int jobs) {
+    char *buf = NULL;
+    size_t size = 0;
+    num_jobs = 1;
+    FILE *in = fmemopen(events, strlen(events), "r");
+    FILE *out = open_memstream(&buf, &size);
+    cr_assert_eq(dtmf_generate(in, out, length), 0, "Generation failed");
+    fclose(in);
+    fclose(out);
+    num_jobs = jobs;
+    in = fmemopen(events, strlen(events), "r");
+    FILE *file = tmpfile();
+    cr_assert_eq(dtmf_generate(in, file, length), 0, "Generation failed");
+    num_jobs = 1;
+    fclose(in);
+    fflush(file);
+    cr_assert_eq(ftell(file), (long)size, "Wrong length. Got: %ld | Expected: %zu", ftell(file), size);
+    rewind(file);
+    for (size_t i = 0; i < size; i++) {
+        int ch = fgetc(file);
+        cr_assert_eq(ch, (unsigned char)buf[i], "Byte %zu differs. Got: %d | Expected: %d",
+                     i, ch, (unsigned char)buf[i]);
+    }
+    cr_assert_eq(fgetc(file), EOF, "File is too long");
+    fclose(file);
+    free(buf);
+}
+
+Test(generate_tests_suite, sparse_output_test) {
+    // Output to a regular file, which may contain holes, must read back the same
+    // as output to a stream that cannot.
+    noise_file = NULL;
+    noise_level = 0;
+    assert_file_output_matches("8000\t9000\t5\n100000\t101000\t#\n", 200000, 1);
+}
+
+Test(generate_tests_suite, parallel_generate_test) {
+    // Segments synthesized by separate threads must join up into exactly the
+    // sequential output, including across event boundaries and runs of silence.
+    noise_file = "rsrc/white_noise_10s.au";
+    noise_level = -10;
+    assert_file_output_matches("0\t8000\t1\n8000\t12000\t2\n20000\t90000\tD\n150000\t150500\t*\n",
+                               200000, 7);
+    noise_file = NULL;
+    noise_level = 0;
+}
+
+Test(generate_tests_suite, validargs_generate_jobs_test) {
+    // -j may come before the other options, which are parsed where they stand.
+    char *argv[] = {"bin/dtmf", "-g", "-j", "4", "-t", "500", "-l", "-5", NULL};
+    char *given[] = {"bin/dtmf", "-g", "-j", "4", "-t", "500", "-l", "-5", NULL};
+    int ret = validargs(8, argv);
+    cr_assert_eq(ret, 0, "Invalid return for valid args.  Got: %d | Expected: %d", ret, 0);
+    cr_assert(num_jobs == 4 && audio_samples == 4000 && noise_level == -5,
+              "Wrong options. Got: %d jobs, %d samples, level %d", num_jobs, audio_samples,
+              noise_level);
+    for (int i = 0; i < 8; i++) {
+        cr_assert_eq(strcmp(argv[i], given[i]), 0, "Argument %d was moved", i);
+    }
+    num_jobs = 1;
+    noise_level = 0;
+}
+
+Test(generate_tests_suite, script_parse_test) {
+    // Well-formed lines are accepted with or without a carriage return, and the
+    // script stops at the end of the last good event before a malformed line.
+    char *events = "0\t800\t1\r\n900\t1900\t#\n2000\t2100 5\n3000\t4000\t7\n";
+    DTMF_SCRIPT script;
+    dtmf_script_init(&script);
+    FILE *in = fmemopen(events, strlen(events), "r");
+    cr_assert_eq(dtmf_script_read(&script, in, 8000), EOF, "Malformed line was accepted");
+    fclose(in);
+    cr_assert_eq(script.count, 2, "Wrong event count. Got: %zu | Expected: 2", script.count);
+    cr_assert_eq(script.length, 1900, "Wrong length. Got: %u | Expected: 1900", script.length);
+    cr_assert_eq(script.events[1].symbol, '#', "Wrong symbol. Got: %c | Expected: #",
+                 script.events[1].symbol);
+    dtmf_script_free(&script);
+
+    // An unterminated last line is accepted, and an event past the end is cut short.
+    events = "0\t800\t1\n900\t1900\tD";
+    in = fmemopen(events, strlen(events), "r");
+    cr_assert_eq(dtmf_script_read(&script, in, 1500), 0, "Script was not accepted");
+    fclose(in);
+    cr_assert_eq(script.count, 2, "Wrong event count. Got: %zu | Expected: 2", script.count);
+    cr_assert_eq(script.events[1].end, 1500, "Wrong end. Got: %u | Expected: 1500",
+                 script.events[1].end);
+    dtmf_script_free(&script);
+}